@@ -4,16 +4,34 @@ set name="StackerClone"
 set CC65_HOME=..\
 set srcDir=src
 set libDir=src\lib
-
-cc65 -Oi %srcDir%\main.c -g --add-source || goto fail
-ca65 %libDir%\crt0.s -g || goto fail
+set toolsDir=tools
+
+REM chrRam=1 builds for CHR-RAM: the tileset is uploaded at reset and the
+REM background animation is streamed in vblank (see tools/chrstream)
+set chrRam=0
+set cfg=nrom_256_horz.cfg
+if "%chrRam%"=="1" set cfg=nrom_256_horz_chrram.cfg
+
+cc65 -Oi %srcDir%\main.c -g --add-source -D CHR_RAM=%chrRam% || goto fail
+REM Only the neslib routines referenced by the game get assembled
+%toolsDir%\nlsyms %libDir%\neslib.h %srcDir%\main.s > %libDir%\neslib_refs.inc || goto fail
+REM Animated tiles for the CHR-RAM streamer and the bytes streamed per vblank
+%toolsDir%\chrstream graphics\tileset.chr %libDir%\chr_anim.inc > %name%_chr.txt || goto fail
+ca65 %libDir%\crt0.s -g -D CHR_RAM=%chrRam% || goto fail
 ca65 %srcDir%\main.s -g || goto fail
-ld65 -C %libDir%\nrom_256_horz.cfg -o %name%.nes %libDir%\crt0.o %srcDir%\main.o nes.lib -Ln labels.txt || goto fail
+ld65 -C %libDir%\%cfg% -o %name%.nes %libDir%\crt0.o %srcDir%\main.o nes.lib -Ln %name%_labels.txt --dbgfile %name%.dbg || goto fail
+REM Per-symbol size and segment map of the PRG ROM
+%toolsDir%\romreport %name%.dbg > %name%_rom.txt || goto fail
+REM Worst-case C stack and hardware stack depth per call path
+%toolsDir%\stackdepth %libDir%\crt0.s %libDir%\neslib.s %libDir%\famitone2.s %srcDir%\main.s > %name%_stack.txt || goto fail
+REM Page-crossing branches and indexed reads in the NMI and FamiTone hot paths
+%toolsDir%\pagecross %name%.nes %name%_labels.txt > %name%_pages.txt || goto fail
+REM Frame windows of perfect, partial and losing presses for every level
+%toolsDir%\timingwindows %srcDir%\gameConstants.h %srcDir%\gamePhase.h > %name%_timing.txt || goto fail
 
 REM del main.s
 del %srcDir%\*.o
 del %libDir%\*.o
-del labels.txt
 
 %name%.nes
 
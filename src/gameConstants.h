@@ -3,7 +3,7 @@
 *  @brief      	Game balancing parameters
 *  @author     	Lori
 *  @created 	November 27, 2017
-*  @modified   	November 27, 2017
+*  @modified   	October 19, 2026
 *      
 *  @par [explanation]
 *		> 
@@ -13,4 +13,8 @@
 #define	INIT_SPEED			24		// Movement in bits/frame
 #define INCREMENT_SPEED 	4		// The increase in speed
 									//  after every successful stack
-#define WIN_STACK_HEIGHT 	10		// Height of the stack needed to win
\ No newline at end of file
+#define WIN_STACK_HEIGHT 	10		// Height of the stack needed to win
+
+// Debugging
+#define SHOW_LAG_FRAMES		0		// 1 to count the frames where the game logic
+									//  did not finish in time, and tint the screen
\ No newline at end of file
@@ -3,10 +3,12 @@
 *  @brief      	Game phase handler
 *  @author     	Lori
 *  @created 	November 26, 2017
-*  @modified   	November 27, 2017
+*  @modified   	October 19, 2026
 *      
 *  @par [explanation]
 *		> Holds code used exclusively in the game phase
+*		> Runs one or two players (split-screen versus) with the same code,
+*		the per-player state lives in arrays indexed by player
 ******************************************************************************/
 
 // Game screen nametable
@@ -21,20 +23,34 @@ const unsigned char block_metasprite[] = {
 	128
 };
 
-// Pre-initialized update list used during gameplay
-#define UPDATE_LIST_SIZE 23
-const unsigned char updateListData[UPDATE_LIST_SIZE] =
+// Tiles of a placed block row, an update list points into these rows
+// so block tiles are never copied. The NMI reads them through a pointer,
+// they go after the neslib tables in the page-aligned HOTDATA segment,
+// where tools/pagecross checks they stay within one page
+#define BLOCK_ROW_TILES 8
+#pragma rodata-name (push,"HOTDATA")
+const unsigned char blockRowTop[BLOCK_ROW_TILES] =
 {
-	MSB(NAMETABLE_C) | NT_UPD_HORZ, LSB(NAMETABLE_C),
-	8,0x40,0x41,0x40,0x41,0x40,0x41,0x40,0x41,
-
-	MSB(NAMETABLE_C) | NT_UPD_HORZ, LSB(NAMETABLE_C),
-	8,0x42,0x43,0x42,0x43,0x42,0x43,0x42,0x43,
-	
-	// End of file marker for VRAM update list
-	NT_UPD_EOF
+	0x40,0x41,0x40,0x41,0x40,0x41,0x40,0x41
+};
+const unsigned char blockRowBottom[BLOCK_ROW_TILES] =
+{
+	0x42,0x43,0x42,0x43,0x42,0x43,0x42,0x43
 };
-static unsigned char updateList[UPDATE_LIST_SIZE];
+#pragma rodata-name (pop)
+
+// Update lists used during gameplay: one NT_UPD_REF entry per block row
+// of every player's last placement, the rows are as long as the placed
+// blocks so a player never overwrites the other half of the screen
+#define MAX_PLAYERS 2
+#define UPDATE_ENTRY_SIZE 5
+#define UPDATE_LIST_SIZE (MAX_PLAYERS * 2 * UPDATE_ENTRY_SIZE + 1)
+
+// Two update lists: the NMI reads the committed one while
+// the next one is written into the other (the back list)
+static unsigned char updateListA[UPDATE_LIST_SIZE];
+static unsigned char updateListB[UPDATE_LIST_SIZE];
+static unsigned char *backList;
 
 // Constants
 
@@ -46,26 +62,54 @@ static unsigned char updateList[UPDATE_LIST_SIZE];
 #define CENTER_X (128 - BLOCK_SIDE)	// The x value of the center
 #define SCREEN_MIN BLOCK_SIDE		// The effective left screen edge
 #define SCREEN_MAX (SCREEN_WIDTH - BLOCK_SIDE)	// The effective right screen edge
-#define TILE_EMPTY 0x00				// A tile in the chr set that is visually empty
-									//  used for making blocks disappear
+#define SCREEN_HALF (SCREEN_WIDTH / 2)			// Split line of the versus mode
+
+// Play area of each player: the whole screen alone, one half each in versus.
+// Indexed by player + playerCount - 1. The spawn points are rounded down to
+// a whole block, so the first group is drawn where its x-position says
+#define BLOCK_ALIGN(x) ((x) & ~(BLOCK_SIDE - 1))
+const unsigned char areaMinX[3] = { SCREEN_MIN, SCREEN_MIN, SCREEN_HALF };
+const unsigned char areaMaxX[3] = { SCREEN_MAX, SCREEN_HALF, SCREEN_MAX };
+const unsigned char areaCenterX[3] =
+{
+	CENTER_X,
+	BLOCK_ALIGN((SCREEN_MIN + SCREEN_HALF) / 2 - BLOCK_SIDE),
+	BLOCK_ALIGN((SCREEN_HALF + SCREEN_MAX) / 2 - BLOCK_SIDE)
+};
 
 // Used in position computation
 // Game uses 12:4 fixed point calculations
 #define FP_BITS	4
 #define TILE_SIZE_BIT 4
-#define TILE_PLUS_FP_BITS (TILE_SIZE_BIT + FP_BITS)
-
-// Variables
-static unsigned int blockPosX;		// Block x-position
-static unsigned char blockCoordX;	// Block coordinates
-static unsigned char blockCoordY;
-static unsigned char blockSpeed; 	// Current movmement speed
-static unsigned char blockSize;		// No. of single-blocks in the block group
-static unsigned char blockWidth; 	// The width of the current block group
-static unsigned char stackHeight;	// Current stack height
-static unsigned char isMoveRight;	// Flags rightward or leftward block movement
-static unsigned char minStackCoordX;// The x coordinate value of the leftmost 
-									//  area where you can place a block
+
+// Variables, one entry per player
+static unsigned int blockPosX[MAX_PLAYERS];		// Block x-position
+static unsigned char blockCoordX[MAX_PLAYERS];	// Block coordinates
+static unsigned char blockCoordY[MAX_PLAYERS];
+static unsigned char blockSpeed[MAX_PLAYERS]; 	// Current movmement speed
+static unsigned char blockSize[MAX_PLAYERS];	// No. of single-blocks in the block group
+static unsigned char blockWidth[MAX_PLAYERS]; 	// The width of the current block group
+static unsigned char stackHeight[MAX_PLAYERS];	// Current stack height
+static unsigned char isMoveRight[MAX_PLAYERS];	// Flags rightward or leftward block movement
+static unsigned char minStackCoordX[MAX_PLAYERS];// The x coordinate value of the leftmost
+												//  area where you can place a block
+static unsigned char areaMin[MAX_PLAYERS];		// Play area edges and start position
+static unsigned char areaMax[MAX_PLAYERS];
+static unsigned char areaCenter[MAX_PLAYERS];
+static unsigned int placedAdr[MAX_PLAYERS];		// Nametable address of the last placement
+static unsigned char placedSize[MAX_PLAYERS];	// No. of single-blocks drawn by it, 0 if none
+
+// Variables shared by the players
+static unsigned char spriteId;		// Next free OAM entry while drawing
+static unsigned char isListDirty;	// Set when a placement changed the update list
+static unsigned char isGameOver;	// Set when a placement ended the game
+#if SHOW_LAG_FRAMES
+static unsigned char frameClock;	// nesclock() when the frame logic started
+static unsigned char lagFrames;		// Frames the logic did not fit in, read it
+									//  from RAM in a debugger after a worst-case game
+#define PPU_MASK_GAME 0x1e			// Normal rendering
+#define PPU_MASK_LAG 0x3e			// Red tint, shown once a lag frame happened
+#endif
 
 void gamePhase(void)
 {	
@@ -89,19 +133,34 @@ void gamePhase(void)
 	
 	// Initialize the game variables
 	gameResult = 0;
-	blockSpeed = INIT_SPEED;
-	blockSize = INIT_BLOCK_SIZE;
-	blockWidth = BLOCK_SIDE * blockSize;
-	blockPosX = CENTER_X << FP_BITS;
-	blockCoordX = CENTER_X >> TILE_SIZE_BIT;
-	blockCoordY = BASE_Y >> TILE_SIZE_BIT;
-	stackHeight = 0;
-	isMoveRight = 1;
-	minStackCoordX = 0;
-
-	// Set up update list
-	memcpy(updateList, updateListData, sizeof(updateListData));
-	set_vram_update(updateList);
+	isGameOver = 0;
+	isListDirty = 0;
+	for (player = 0; player < playerCount; ++player)
+	{
+		i = player + playerCount - 1;
+		areaMin[player] = areaMinX[i];
+		areaMax[player] = areaMaxX[i];
+		areaCenter[player] = areaCenterX[i];
+		
+		blockSpeed[player] = INIT_SPEED;
+		blockSize[player] = INIT_BLOCK_SIZE;
+		blockWidth[player] = BLOCK_SIDE * INIT_BLOCK_SIZE;
+		blockPosX[player] = areaCenter[player] << FP_BITS;
+		blockCoordX[player] = areaCenter[player] >> TILE_SIZE_BIT;
+		blockCoordY[player] = BASE_Y >> TILE_SIZE_BIT;
+		stackHeight[player] = 0;
+		isMoveRight[player] = 1;
+		minStackCoordX[player] = 0;
+		placedSize[player] = 0;
+	}
+
+	// Set up the update lists, nothing is committed before the first placement
+	backList = updateListA;
+	
+#if SHOW_LAG_FRAMES
+	lagFrames = 0;
+	frameClock = nesclock();
+#endif
 	
 	// Play the game bgm
 	music_play(MUSIC_GAME);
@@ -109,134 +168,193 @@ void gamePhase(void)
 	while (1)
 	{
 		// Display the moving blocks
-		for (i = 0; i < blockSize; ++i)
+		// Two groups on the same row need up to 16 sprites per scanline,
+		// so the drawing order alternates every frame: the sprites over
+		// the limit of 8 then flicker instead of one group vanishing.
+		// Both groups together use at most 2*4*4 = 32 of the 64 sprites
+		player = frameCounter & (playerCount - 1);
+		spriteId = 0;
+		for (j = 0; j < playerCount; ++j)
+		{
+			for (i = 0; i < blockSize[player]; ++i)
+			{
+				spriteId = oam_meta_spr((blockCoordX[player] + i) << TILE_SIZE_BIT,
+					blockCoordY[player] << TILE_SIZE_BIT,
+					spriteId,
+					block_metasprite);
+			}
+			player ^= 1;
+		}
+		oam_hide_rest(spriteId);
+		
+#if SHOW_LAG_FRAMES
+		// A frame has passed while the logic ran: it did not fit in one frame
+		if (nesclock() != frameClock)
 		{
-			oam_meta_spr((blockCoordX + i) << TILE_SIZE_BIT,
-				blockCoordY << TILE_SIZE_BIT,
-				i << 4,
-				block_metasprite);
+			++lagFrames;
+			ppu_mask(PPU_MASK_LAG);
 		}
+#endif
 		
 		// Wait for the frame to finish
 		ppu_wait_frame();
 		++frameCounter;
+#if SHOW_LAG_FRAMES
+		frameClock = nesclock();
+#endif
 		
 		// Animate the BG via CHR bank switching
-		bank_bg((frameCounter >> 4)&1);
+		bgAnimate((frameCounter >> 4)&1);
 		
-		// Update block positions
-		if (isMoveRight)
+		for (player = 0; player < playerCount; ++player)
 		{
-			blockPosX += blockSpeed;
-		}
-		else
-		{
-			blockPosX -= blockSpeed;
-		}
+			// Update block positions
+			if (isMoveRight[player])
+			{
+				blockPosX[player] += blockSpeed[player];
+			}
+			else
+			{
+				blockPosX[player] -= blockSpeed[player];
+			}
 
-		// Remove insignificant bits from the x-position value
-		//  to get the x-coordinate value
-		blockCoordX = blockPosX >> TILE_PLUS_FP_BITS;
-		// Check the discarded bits if rounding up should be done
-		if ((((blockPosX & 0x00f0) >> FP_BITS)) >= 8)
-		{	
-			blockCoordX += 1;
-		}
-		
-		// Check if block group has hit the game area edges
-		if ((blockPosX >> FP_BITS) <= SCREEN_MIN ||
-			(blockPosX >> FP_BITS) >= (SCREEN_MAX - blockWidth))
-		{
-			// Reverse the movement direction when hitting the screen edge
-			isMoveRight ^= 1;
-		}
-		
-		// Check for any player input
-		if (pad_trigger(0))
-		{
+			// Remove the fraction bits once, the pixel x-position
+			//  serves both the coordinate and the edge checks
+			var16Bit = blockPosX[player] >> FP_BITS;
+			// Round the pixel x-position to the nearest block
+			//  to get the x-coordinate value
+			blockCoordX[player] = (var16Bit + (BLOCK_SIDE / 2)) >> TILE_SIZE_BIT;
+			
+			// Check if block group has hit the play area edges
+			if (var16Bit <= areaMin[player] ||
+				var16Bit >= (areaMax[player] - blockWidth[player]))
+			{
+				// Reverse the movement direction when hitting the area edge
+				isMoveRight[player] ^= 1;
+			}
+			
+			// Check for any player input
+			if (!pad_trigger(player))
+			{
+				continue;
+			}
+			
 			// Initialize minStackCoordX for the very first block
-			if (stackHeight < 1)
+			if (stackHeight[player] < 1)
 			{
-				minStackCoordX = blockCoordX;
+				minStackCoordX[player] = blockCoordX[player];
 			}
+			placedSize[player] = blockSize[player];
 			
 			// Check for floating blocks:
 			// happens when the leftmost block is not directly
 			// on top of the leftmost previously placed block
-			if (blockCoordX != minStackCoordX)
+			if (blockCoordX[player] != minStackCoordX[player])
 			{
-				// Clear the OAM to get rid of unneeded sprites
-				oam_clear();
-				
 				// j will store the number of floating blocks
-				j = (blockCoordX < minStackCoordX) ?
-					(minStackCoordX - blockCoordX): // Extra blocks to the left
-					(blockCoordX - minStackCoordX); // Extra blocks to the right
-				if (j > blockSize)
+				j = (blockCoordX[player] < minStackCoordX[player]) ?
+					(minStackCoordX[player] - blockCoordX[player]): // Extra blocks to the left
+					(blockCoordX[player] - minStackCoordX[player]); // Extra blocks to the right
+				if (j > blockSize[player])
 				{
-					j = blockSize;
+					j = blockSize[player];
 				}
 				
 				// If player is not about to lose,
-				// floating blocks are converted to empty tiles
-				if (blockSize != j)
+				// floating blocks are not drawn
+				if (blockSize[player] != j)
 				{
-					// Make sure the number of visible block tiles in the updateList
-					// matches the resulting number of remaining blocks
-					for (i = 0; i < (j << 1); ++i)
-					{
-						updateList[2 + (blockSize << 1) - i] = TILE_EMPTY;
-						updateList[13 + (blockSize << 1) - i] = TILE_EMPTY;
-					}
+					placedSize[player] = blockSize[player] - j;
 				}
 				
 				// Update the stackable area edge
-				if (blockCoordX > minStackCoordX ||
-					blockSize == j) // Added to show how player loses
+				if (blockCoordX[player] > minStackCoordX[player] ||
+					blockSize[player] == j) // Added to show how player loses
 				{
-					minStackCoordX = blockCoordX;
+					minStackCoordX[player] = blockCoordX[player];
 				}
 				
 				// Update the block count
-				blockSize -= j;
-				blockWidth = BLOCK_SIDE * blockSize;
+				blockSize[player] -= j;
+				blockWidth[player] = BLOCK_SIDE * blockSize[player];
 				// TODO: Remove multiplication above
 			}
 			
 			// Fix stacked blocks in their current position
-			// by converting them into background tiles	
-			// Update the addresses in the updateList to correctly show this
-			var16Bit = NTADR_A(minStackCoordX << 1, (blockCoordY - 1) << 1);
-			updateList[0] = MSB(var16Bit) | NT_UPD_HORZ;
-			updateList[1] = LSB(var16Bit);
-			var16Bit += 32;
-			updateList[11] = MSB(var16Bit) | NT_UPD_HORZ;
-			updateList[12] = LSB(var16Bit);
+			// by converting them into background tiles,
+			// the update list is rebuilt once all players are done
+			placedAdr[player] = NTADR_A(minStackCoordX[player] << 1,
+				(blockCoordY[player] - 1) << 1);
+			isListDirty = 1;
 			
 			// Check if gameover: no part of the block group landed correctly
-			if (blockSize == 0)
+			// In versus this is a win for the other player
+			if (blockSize[player] == 0)
 			{
-				gameResult = 0;
+				gameResult = (playerCount > 1);
+				winner = player ^ 1;
+				isGameOver = 1;
 				break;
 			}
 			
 			// Check if game has been won
-			++stackHeight;
-			if (stackHeight >= WIN_STACK_HEIGHT)
+			++stackHeight[player];
+			if (stackHeight[player] >= WIN_STACK_HEIGHT)
 			{
 				gameResult = 1;
+				winner = player;
+				isGameOver = 1;
 				break;
 			}
 			
 			// Compute the new position of the next block
-			blockPosX = CENTER_X << FP_BITS;
-			blockCoordX = CENTER_X >> TILE_SIZE_BIT;
-			blockCoordY -= 1;
+			blockPosX[player] = areaCenter[player] << FP_BITS;
+			blockCoordX[player] = areaCenter[player] >> TILE_SIZE_BIT;
+			blockCoordY[player] -= 1;
 			// Randomize the next movement direction
-			isMoveRight = (rand8() < 128) ? 0 : 1;
+			isMoveRight[player] = (rand8() < 128) ? 0 : 1;
 			
 			// Increase block speed
-			blockSpeed += INCREMENT_SPEED;
+			blockSpeed[player] += INCREMENT_SPEED;
+		}
+		
+		// Write the placements of this frame into the back list
+		// and commit them together, the tiles are read from ROM
+		if (isListDirty)
+		{
+			isListDirty = 0;
+			i = 0;
+			for (player = 0; player < playerCount; ++player)
+			{
+				if (!placedSize[player])
+				{
+					continue;
+				}
+				
+				var16Bit = placedAdr[player];
+				backList[i++] = MSB(var16Bit) | NT_UPD_REF;
+				backList[i++] = LSB(var16Bit);
+				backList[i++] = placedSize[player] << 1;
+				backList[i++] = LSB((unsigned int)blockRowTop);
+				backList[i++] = MSB((unsigned int)blockRowTop);
+				
+				var16Bit += 32;
+				backList[i++] = MSB(var16Bit) | NT_UPD_REF;
+				backList[i++] = LSB(var16Bit);
+				backList[i++] = placedSize[player] << 1;
+				backList[i++] = LSB((unsigned int)blockRowBottom);
+				backList[i++] = MSB((unsigned int)blockRowBottom);
+			}
+			backList[i] = NT_UPD_EOF;
+			
+			// Commit the back list and write the next placement into the other one
+			set_vram_update(backList);
+			backList = (backList == updateListA) ? updateListB : updateListA;
+		}
+		
+		if (isGameOver)
+		{
+			break;
 		}
 	}
 	
@@ -244,6 +362,10 @@ void gamePhase(void)
 	delay(1);
 	oam_clear();
 	
-	// Stop updating block visuals through updateList
+	// Stop updating block visuals through the update lists
 	set_vram_update(NULL);
+	
+#if SHOW_LAG_FRAMES
+	ppu_mask(PPU_MASK_GAME);
+#endif
 }
@@ -2,19 +2,49 @@
 ; based on code by Groepaz/Hitmen <groepaz@gmx.net>, Ullrich von Bassewitz <uz@cc65.org>
 
 
+	.include "neslib_refs.inc"	;NL_REF_* flags for the neslib routines the game calls
+
+
 FT_DPCM_OFF				= $c000		;$c000..$ffc0, 64-byte steps
 FT_SFX_STREAMS			= 4			;number of sound effects played at once, 1..4
 
 .define FT_DPCM_ENABLE  0			;undefine to exclude all DMC code
-.define FT_SFX_ENABLE   1			;undefine to exclude all sound effects code
+.define FT_SFX_ENABLE   NL_REF_sfx_play	;sound effects code is only kept when sfx_play is called
 .define FT_MUSIC_ENABLE	1			;undefine to disable music (does not exclude music code)
 
+.define STACK_WATERMARK 0			;1 fills the C stack with STACK_FILL at reset, see stack_watermark()
+STACK_FILL				= $a5
+
+.define PROFILER 0					;1 samples the interrupted PC in every NMI, needs PRG-RAM, see tools/pcprofile
+PROFILER_BUF			= $6000		;1 KB of 16-bit counters, battery backed cart RAM so flash carts save it
+PROFILER_SIGN			= PROFILER_BUF+$400	;profSign, the counters are kept across resets while it matches
+
+.ifndef CHR_RAM
+CHR_RAM					= 0			;1 for the CHR-RAM build, compile.bat sets it with its linker config
+.endif
+CHR_STREAM_TILES		= 4			;tiles streamed per vblank when nothing else is uploaded
+CHR_STREAM_PAL			= 2			;tiles the palette upload takes off that budget
+
+;NMI worst cases, counted in cycles against the ~2273 of an NTSC vblank:
+;entry and OAM DMA 540, pad read 264, checks, list swap and the PPU_CTRL/
+;scroll/mask writes 128, so about 1340 are left. The palette upload takes
+;410, an 8-tile NT_UPD_REF row 241 (plus 32 for the end of the list), a
+;streamed tile 254 (plus 55 per run), so every update list entry takes one
+;tile off the budget and the palette CHR_STREAM_PAL:
+;  no list, 4 tiles                   2003
+;  palette, 2 tiles                   1905
+;  2 rows (one player), 2 tiles       2009
+;  4 rows (versus), no tiles          1928
+;The game never uploads the palette while its update list is on, palette
+;and 4 rows alone would take 2338
+
 
     .export _exit,__STARTUP__:absolute=1
 	.import initlib,push0,popa,popax,_main,zerobss,copydata
 
 ; Linker generated symbols
 	.import __RAM_START__   ,__RAM_SIZE__
+	.import __STACK_START__ ,__STACK_SIZE__
 	.import __ROM0_START__  ,__ROM0_SIZE__
 	.import __STARTUP_LOAD__,__STARTUP_RUN__,__STARTUP_SIZE__
 	.import	__CODE_LOAD__   ,__CODE_RUN__   ,__CODE_SIZE__
@@ -58,6 +88,9 @@ FRAME_CNT2: 		.res 1
 VRAM_UPDATE: 		.res 1
 NAME_UPD_ADR: 		.res 2
 NAME_UPD_ENABLE: 	.res 1
+NAME_UPD_NEXT: 		.res 2		;list committed by set_vram_update, taken by the NMI
+NAME_UPD_SWAP: 		.res 1		;set when NAME_UPD_NEXT holds a complete pointer
+NAME_UPD_REF: 		.res 2		;tile pointer of a NT_UPD_REF sequence
 PAL_UPDATE: 		.res 1
 PAL_BG_PTR: 		.res 2
 PAL_SPR_PTR: 		.res 2
@@ -68,6 +101,19 @@ SCROLL_Y1: 			.res 1
 PAD_STATE: 			.res 2		;one byte per controller
 PAD_STATEP: 		.res 2
 PAD_STATET: 		.res 2
+PAD_READ: 			.res 2		;both pads, read by the NMI after the OAM DMA
+PAD_FRAME: 			.res 1		;FRAME_CNT1 value of the frame they were read in
+
+.if(CHR_RAM)
+CHR_STR_SRC: 		.res 2		;next byte of the tile runs, MSB is 0 when idle
+CHR_STR_ADR: 		.res 2		;PPU address of the next tile
+CHR_STR_LEFT: 		.res 1		;tiles left in the current run
+CHR_STR_TABLE: 		.res 1		;$00 or $10, pattern table the runs go to
+CHR_STR_BUDGET: 	.res 1		;tiles the next NMI may upload
+.endif
+.if(PROFILER)
+PROF_TMP: 			.res 1		;bucket MSB of the sampled PC
+.endif
 PPU_CTRL_VAR: 		.res 1
 PPU_CTRL_VAR1: 		.res 1
 PPU_MASK_VAR: 		.res 1
@@ -76,8 +122,6 @@ FT_TEMP: 			.res 3
 
 TEMP: 				.res 11
 
-PAD_BUF		=TEMP+1
-
 PTR			=TEMP	;word
 LEN			=TEMP+2	;word
 NEXTSPR		=TEMP+4
@@ -98,7 +142,7 @@ RLE_BYTE	=TEMP+3
     .byte $4e,$45,$53,$1a
 	.byte <NES_PRG_BANKS
 	.byte <NES_CHR_BANKS
-	.byte <NES_MIRRORING|(<NES_MAPPER<<4)
+	.byte <NES_MIRRORING|(<NES_MAPPER<<4)|(PROFILER<<1)
 	.byte <NES_MAPPER&$f0
 	.res 8,0
 
@@ -153,6 +197,45 @@ clearVRAM:
 	dey
 	bne @1
 
+.if(CHR_RAM)
+
+uploadCHR:					;the first pattern table of the tileset, into both tables
+
+	.assert NES_CHR_BANKS = 0, error, "CHR_RAM needs a linker config with NES_CHR_BANKS = 0"
+	ldx #$00
+@table:
+	stx PPU_ADDR
+	lda #$00
+	sta PPU_ADDR
+	lda #<chrTileset
+	sta <PTR
+	lda #>chrTileset
+	sta <PTR+1
+	lda #$10
+	sta <LEN
+	ldy #0
+@1:
+	lda (PTR),y
+	sta PPU_DATA
+	iny
+	bne @1
+	inc <PTR+1
+	dec <LEN
+	bne @1
+	txa
+	clc
+	adc #$10
+	tax
+	cpx #$20
+	bne @table
+	ldx #0
+
+.else
+
+	.assert NES_CHR_BANKS <> 0, error, "NES_CHR_BANKS = 0 needs CHR_RAM set"
+
+.endif
+
 clearRAM:
 
     txa
@@ -168,6 +251,55 @@ clearRAM:
     inx
     bne @1
 
+.if(PROFILER)
+
+checkProfile:
+
+	ldy #profSignEnd-profSign-1
+@1:
+	lda profSign,y
+	cmp PROFILER_SIGN,y
+	bne @clear				;first run, or the RAM holds another build's samples
+	dey
+	bpl @1
+	bmi @keep				;bra, the samples of the earlier sessions stay
+
+@clear:
+
+	txa
+@2:
+	sta PROFILER_BUF+$000,x
+	sta PROFILER_BUF+$100,x
+	sta PROFILER_BUF+$200,x
+	sta PROFILER_BUF+$300,x
+	inx
+	bne @2
+
+	ldy #profSignEnd-profSign-1
+@3:
+	lda profSign,y
+	sta PROFILER_SIGN,y
+	dey
+	bpl @3
+
+@keep:
+
+.endif
+
+.if(STACK_WATERMARK)
+
+fillStack:
+
+	.assert __STACK_SIZE__ <= $100, error, "STACK_WATERMARK needs a stack of one page or less"
+	lda #STACK_FILL
+@1:
+	sta __STACK_START__,x
+	inx
+	cpx #<__STACK_SIZE__
+	bne @1
+
+.endif
+
 	lda #4
 	jsr _pal_bright
 	jsr _pal_clear
@@ -176,9 +308,9 @@ clearRAM:
     jsr	zerobss
 	jsr	copydata
 
-    lda #<(__RAM_START__+__RAM_SIZE__)
+    lda #<(__STACK_START__+__STACK_SIZE__)
     sta	sp
-    lda	#>(__RAM_START__+__RAM_SIZE__)
+    lda	#>(__STACK_START__+__STACK_SIZE__)
     sta	sp+1            ; Set argument stack ptr
 
 	jsr	initlib
@@ -244,6 +376,18 @@ sounds_data:
 	.include "../soundsAndMusic/sounds.s"
 .endif
 
+.if(PROFILER)
+profSign:
+	.byte "PROF",<__CODE_SIZE__,>__CODE_SIZE__	;a rebuild that moves the code clears the counters
+profSignEnd:
+.endif
+
+.if(CHR_RAM)
+chrTileset:
+	.incbin "../../graphics/tileset.chr", 0, $1000	;first table only, see uploadCHR
+	.include "chr_anim.inc"						;animated tiles, streamed by chr_stream
+.endif
+
 .segment "SAMPLES"
 
 .if(FT_DPCM_ENABLE)
@@ -257,5 +401,7 @@ sounds_data:
    	.word irq	;$fffe irq / brk
 
 
+.if(!CHR_RAM)
 .segment "CHARS"
-	.incbin "../../graphics/tileset.chr"
\ No newline at end of file
+	.incbin "../../graphics/tileset.chr"
+.endif
\ No newline at end of file
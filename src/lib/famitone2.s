@@ -323,6 +323,8 @@ FamiToneMusicStop:
 ; in: A number of subsong
 ;------------------------------------------------------------------------------
 
+	.if(NL_music_play)				;only kept when music_play is called
+
 FamiToneMusicPlay:
 
 	ldx FT_SONG_LIST_L
@@ -396,12 +398,16 @@ FamiToneMusicPlay:
 @skip:
 	rts
 
+	.endif
+
 
 ;------------------------------------------------------------------------------
 ; pause and unpause current music
 ; in: A 0 or not 0 to play or pause
 ;------------------------------------------------------------------------------
 
+	.if(NL_music_pause)				;only kept when music_pause is called
+
 FamiToneMusicPause:
 
 	tax					;set SZ flags for A
@@ -423,6 +429,8 @@ FamiToneMusicPause:
 
 	rts
 
+	.endif
+
 
 ;------------------------------------------------------------------------------
 ; update FamiTone state, should be called every NMI
@@ -1200,6 +1208,11 @@ _FT2DummyEnvelope:
 ;PAL and NTSC, 11-bit dividers
 ;rest note, then octaves 1-5, then three zeroes
 ;first 64 bytes are PAL, next 64 bytes are NTSC
+;both tables fill the first page of the page-aligned HOTDATA segment, so the
+;indexed reads in the update never cross a page
+
+	.pushseg
+	.segment "HOTDATA"
 
 _FT2NoteTableLSB:
 	.if(FT_PAL_SUPPORT)
@@ -1227,3 +1240,5 @@ _FT2NoteTableMSB:
 	.byte $01,$01,$00,$00,$00,$00,$00,$00,$00,$00,$00,$00,$00,$00,$00,$00
 	.byte $00,$00,$00,$00,$00,$00,$00,$00,$00,$00,$00,$00,$00,$00,$00,$00
 	.endif
+
+	.popseg
@@ -80,6 +80,10 @@ void __fastcall__ ppu_mask(unsigned char mask);
 
 unsigned char __fastcall__ ppu_system(void);
 
+//get the frame counter, incremented by every NMI
+
+unsigned char __fastcall__ nesclock(void);
+
 
 
 //clear OAM buffer, all the sprites are hidden
@@ -132,6 +136,8 @@ void __fastcall__ sample_play(unsigned char sample);
 
 
 //poll controller and return flags like PAD_LEFT etc, input is pad number (0 or 1)
+//both pads are read once per frame by the NMI, right after the OAM DMA so a DPCM
+//sample can't corrupt the reads; this returns the state of the latest NMI
 
 unsigned char __fastcall__ pad_poll(unsigned char pad);
 
@@ -145,6 +151,10 @@ unsigned char __fastcall__ pad_trigger(unsigned char pad);
 
 unsigned char __fastcall__ pad_state(unsigned char pad);
 
+//get the frame number, as returned by nesclock, of the latest pad read
+
+unsigned char __fastcall__ pad_frame(void);
+
 
 //set scroll, including rhe top bits
 //it is always applied at beginning of a TV frame, not at the function call
@@ -186,19 +196,39 @@ void __fastcall__ set_rand(unsigned int seed);
 //in a special format. It allows to write non-sequential bytes, as well as horizontal or
 //vertical nametable sequences.
 //buffer pointer could be changed during rendering, but it only takes effect on a new frame
+//the pointer is committed with a single store, so a game can build the next list in a
+//back buffer while the NMI still reads the current one, then swap them with this call;
+//the old list is not read anymore once the next ppu_wait_frame or ppu_wait_nmi returns
 //number of transferred bytes is limited by vblank time
-//to disable updates, call this function with NULL pointer
+//to disable updates, call this function with NULL pointer; unlike a new list this takes
+//effect at once: no NMI reads the old list after the call returns, and a list committed
+//but not taken yet is dropped
 
 //the update data format:
 // MSB, LSB, byte for a non-sequential write
 // MSB|NT_UPD_HORZ, LSB, LEN, [bytes] for a horizontal sequence
 // MSB|NT_UPD_VERT, LSB, LEN, [bytes] for a vertical sequence
+// MSB|NT_UPD_REF, LSB, LEN, pointer LSB, pointer MSB for a horizontal sequence whose bytes
+//   are read through the pointer, so constant tiles can stay in ROM (not for the palette,
+//   $3f|NT_UPD_REF is the same as NT_UPD_EOF)
 // NT_UPD_EOF to mark end of the buffer
 
 //length of this data should be under 256 bytes
 
 void __fastcall__ set_vram_update(unsigned char *buf);
 
+//CHR-RAM build only (CHR_RAM set): stream tile runs into pattern table 0 or 1 during
+//vblank, CHR_STREAM_TILES tiles (16 bytes each) per frame after the update list, less
+//CHR_STREAM_PAL on frames with a palette update and one per update list entry flushed
+//in the same vblank. Run format: address MSB, address LSB (inside the pattern table),
+//tile count, 16 bytes per tile; $ff ends the list
+
+void __fastcall__ chr_stream(unsigned char table,const unsigned char *runs);
+
+//CHR-RAM build only: not 0 while chr_stream still has tiles to upload
+
+unsigned char __fastcall__ chr_stream_busy(void);
+
 //all following vram functions only work when display is disabled
 
 //do a series of VRAM writes, the same format as for set_vram_update, but writes done right away
@@ -248,6 +278,15 @@ void __fastcall__ memfill(void *dst,unsigned char value,unsigned int len);
 
 void __fastcall__ delay(unsigned char frames);
 
+//get the deepest C stack use since reset in bytes, works only with STACK_WATERMARK set in crt0.s
+//compare it with the tools/stackdepth report when changing __STACKSIZE__ in the linker config
+
+unsigned char __fastcall__ stack_watermark(void);
+
+//PROFILER set in crt0.s: the NMI counts the PC it interrupted in PRG-RAM at $6000, which
+//plain NROM boards do not have, so run such a build in an emulator or on a board or flash
+//cart with PRG-RAM; the counters survive resets, read them with tools/pcprofile
+
 
 
 #define PAD_A			0x01
@@ -282,6 +321,7 @@ void __fastcall__ delay(unsigned char frames);
 
 #define NT_UPD_HORZ		0x40
 #define NT_UPD_VERT		0x80
+#define NT_UPD_REF		0xc0
 #define NT_UPD_EOF		0xff
 
 #define MS_EOF			128
@@ -3,21 +3,62 @@
 ;Feel free to do anything you want with this code, consider it Public Domain
 
 
-	.export _pal_all,_pal_bg,_pal_spr,_pal_col,_pal_clear
-	.export _pal_bright,_pal_spr_bright,_pal_bg_bright
-	.export _ppu_off,_ppu_on_all,_ppu_on_bg,_ppu_on_spr,_ppu_mask,_ppu_system
-	.export _oam_clear,_oam_size,_oam_spr,_oam_meta_spr,_oam_hide_rest
-	.export _ppu_wait_frame,_ppu_wait_nmi
-	.export _scroll,_split
-	.export _bank_spr,_bank_bg
-	.export _vram_read,_vram_write
-	.export _music_play,_music_stop,_music_pause
-	.export _sfx_play,_sample_play
-	.export _pad_poll,_pad_trigger,_pad_state
-	.export _rand8,_rand16,_set_rand
-	.export _vram_adr,_vram_put,_vram_fill,_vram_inc,_vram_unrle
-	.export _set_vram_update,_flush_vram_update
-	.export _memcpy,_memfill,_delay
+;Every routine below is assembled only when its NL_ flag is set, so the ones the
+;game never calls do not take PRG space. NL_REF_* flags come from neslib_refs.inc,
+;generated by tools/nlsyms from the cc65 output; the rest are needed by the
+;startup code or by other library routines.
+
+NL_pal_all			= NL_REF_pal_all|NL_REF_pal_bg|NL_REF_pal_spr	;pal_copy
+NL_pal_bg			= NL_REF_pal_bg
+NL_pal_spr			= NL_REF_pal_spr
+NL_pal_col			= NL_REF_pal_col
+NL_pal_clear		= 1												;startup code
+NL_pal_bright		= 1												;startup code
+NL_pal_spr_bright	= NL_REF_pal_spr_bright|NL_pal_bright
+NL_pal_bg_bright	= NL_REF_pal_bg_bright|NL_pal_bright
+NL_ppu_off			= 1												;startup code
+NL_ppu_on_all		= NL_REF_ppu_on_all|NL_REF_ppu_on_bg|NL_REF_ppu_on_spr	;ppu_onoff
+NL_ppu_on_bg		= NL_REF_ppu_on_bg
+NL_ppu_on_spr		= NL_REF_ppu_on_spr
+NL_ppu_mask			= NL_REF_ppu_mask
+NL_ppu_system		= NL_REF_ppu_system
+NL_nesclock			= NL_REF_nesclock
+NL_oam_clear		= 1												;startup code
+NL_oam_size			= NL_REF_oam_size
+NL_oam_spr			= NL_REF_oam_spr
+NL_oam_meta_spr		= NL_REF_oam_meta_spr
+NL_oam_hide_rest	= NL_REF_oam_hide_rest
+NL_ppu_wait_frame	= NL_REF_ppu_wait_frame
+NL_ppu_wait_nmi		= 1												;ppu_off, delay
+NL_vram_unrle		= NL_REF_vram_unrle
+NL_scroll			= NL_REF_scroll
+NL_split			= NL_REF_split
+NL_bank_spr			= NL_REF_bank_spr
+NL_bank_bg			= NL_REF_bank_bg
+NL_vram_read		= NL_REF_vram_read
+NL_vram_write		= NL_REF_vram_write
+NL_music_play		= NL_REF_music_play
+NL_music_stop		= NL_REF_music_stop
+NL_music_pause		= NL_REF_music_pause
+NL_sfx_play			= NL_REF_sfx_play
+NL_sample_play		= NL_REF_sample_play
+NL_pad_poll			= NL_REF_pad_poll|NL_REF_pad_trigger
+NL_pad_trigger		= NL_REF_pad_trigger
+NL_pad_state		= NL_REF_pad_state
+NL_pad_frame		= NL_REF_pad_frame
+NL_rand8			= NL_REF_rand8
+NL_rand16			= NL_REF_rand16
+NL_set_rand			= NL_REF_set_rand
+NL_set_vram_update	= NL_REF_set_vram_update
+NL_flush_vram_update= NL_REF_flush_vram_update
+NL_vram_adr			= NL_REF_vram_adr
+NL_vram_put			= NL_REF_vram_put
+NL_vram_fill		= NL_REF_vram_fill
+NL_vram_inc			= NL_REF_vram_inc
+NL_memcpy			= NL_REF_memcpy
+NL_memfill			= NL_REF_memfill
+NL_delay			= NL_REF_delay
+NL_stack_watermark	= NL_REF_stack_watermark
 
 
 
@@ -30,6 +71,39 @@ nmi:
 	tya
 	pha
 
+	lda #>OAM_BUF		;update OAM
+	sta PPU_OAM_DMA
+
+	;read both pads in one pass right after the OAM DMA: it leaves the CPU on a
+	;known cycle parity, and with the strobe taking an odd number of cycles and
+	;the loop an even one, the port reads never share a cycle with a DMC DMA,
+	;so the DPCM bit deletion cannot corrupt them and no re-reads are needed
+
+	lda #$80			;2	bit 7 shifts out into carry after 8 reads
+	sta <PAD_READ+0		;3
+	ldx #1				;2
+	stx CTRL_PORT1		;4
+	dex					;2
+	stx CTRL_PORT1		;4	17 cycles
+
+@padReadLoop:
+
+	lda CTRL_PORT2		;4
+	and #3				;2	standard or Famicom expansion controller
+	cmp #1				;2
+	ror <PAD_READ+1,x	;6	X is 0, zp,x for one more cycle
+	lda CTRL_PORT1		;4
+	and #3				;2
+	cmp #1				;2
+	ror <PAD_READ+0		;5
+	bcc @padReadLoop	;3	30 cycles
+
+	.assert >* = >@padReadLoop, error, "pad read loop branch crosses a page"
+
+	ldx <FRAME_CNT1		;the frame number nesclock() returns after this NMI
+	inx
+	stx <PAD_FRAME
+
 	lda <PPU_MASK_VAR	;if rendering is disabled, do not access the VRAM at all
 	and #%00011000
 	bne @doUpdate
@@ -37,9 +111,6 @@ nmi:
 
 @doUpdate:
 
-	lda #>OAM_BUF		;update OAM
-	sta PPU_OAM_DMA
-
 	lda <PAL_UPDATE		;update palette if needed
 	bne @updPal
 	jmp @updVRAM
@@ -49,6 +120,11 @@ nmi:
 	ldx #0
 	stx <PAL_UPDATE
 
+.if(CHR_RAM)
+	lda #CHR_STREAM_TILES-CHR_STREAM_PAL	;the palette takes part of the vblank time
+	sta <CHR_STR_BUDGET
+.endif
+
 	lda #$3f
 	sta PPU_ADDR
 	stx PPU_ADDR
@@ -88,12 +164,31 @@ nmi:
 	beq @skipUpd
 	lda #0
 	sta <VRAM_UPDATE
-	
+
+	lda <NAME_UPD_SWAP		;take the list committed by set_vram_update, if any
+	beq @noSwap
+	lda <NAME_UPD_NEXT+0
+	sta <NAME_UPD_ADR+0
+	ora <NAME_UPD_NEXT+1
+	sta <NAME_UPD_ENABLE
+	lda <NAME_UPD_NEXT+1
+	sta <NAME_UPD_ADR+1
+	lda #0
+	sta <NAME_UPD_SWAP
+
+@noSwap:
+
 	lda <NAME_UPD_ENABLE
-	beq @skipUpd
+	beq @updChr
 
 	jsr _flush_vram_update_nmi
 
+@updChr:
+
+.if(CHR_RAM)
+	jsr chr_stream_nmi		;tiles go after the update list, in the vblank time left
+.endif
+
 @skipUpd:
 
 	lda #0
@@ -125,6 +220,44 @@ nmi:
 
 	jsr FamiToneUpdate
 
+.if(PROFILER)
+
+	;count the interrupted PC in its 64-byte bucket of the PRG ROM,
+	;LSBs of the 512 counters first, MSBs $200 bytes after them
+
+	tsx
+	lda $0106,x				;PCH, under Y, X, A and P
+	bpl @profDone			;RAM code, not in the histogram
+	sta <PROF_TMP
+	lda $0105,x				;PCL
+	asl a
+	rol <PROF_TMP
+	asl a
+	rol <PROF_TMP			;bucket LSB, carry is its bit 8
+	ldx <PROF_TMP
+	bcs @profUpper
+
+	inc PROFILER_BUF+$000,x
+	bne @profDone
+	inc PROFILER_BUF+$200,x
+	bne @profDone
+	dec PROFILER_BUF+$000,x	;saturate at $ffff
+	dec PROFILER_BUF+$200,x
+	jmp @profDone
+
+@profUpper:
+
+	inc PROFILER_BUF+$100,x
+	bne @profDone
+	inc PROFILER_BUF+$300,x
+	bne @profDone
+	dec PROFILER_BUF+$100,x
+	dec PROFILER_BUF+$300,x
+
+@profDone:
+
+.endif
+
 	pla
 	tay
 	pla
@@ -139,6 +272,10 @@ irq:
 
 ;void __fastcall__ pal_all(const char *data);
 
+.if(NL_pal_all)
+
+	.export _pal_all
+
 _pal_all:
 
 	sta <PTR
@@ -165,10 +302,16 @@ pal_copy:
 
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ pal_bg(const char *data);
 
+.if(NL_pal_bg)
+
+	.export _pal_bg
+
 _pal_bg:
 
 	sta <PTR
@@ -177,10 +320,16 @@ _pal_bg:
 	lda #$10
 	bne pal_copy ;bra
 
+.endif
+
 
 
 ;void __fastcall__ pal_spr(const char *data);
 
+.if(NL_pal_spr)
+
+	.export _pal_spr
+
 _pal_spr:
 
 	sta <PTR
@@ -189,10 +338,16 @@ _pal_spr:
 	txa
 	bne pal_copy ;bra
 
+.endif
+
 
 
 ;void __fastcall__ pal_col(unsigned char index,unsigned char color);
 
+.if(NL_pal_col)
+
+	.export _pal_col
+
 _pal_col:
 
 	sta <PTR
@@ -204,10 +359,16 @@ _pal_col:
 	inc <PAL_UPDATE
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ pal_clear(void);
 
+.if(NL_pal_clear)
+
+	.export _pal_clear
+
 _pal_clear:
 
 	lda #$0f
@@ -222,10 +383,16 @@ _pal_clear:
 	stx <PAL_UPDATE
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ pal_spr_bright(unsigned char bright);
 
+.if(NL_pal_spr_bright)
+
+	.export _pal_spr_bright
+
 _pal_spr_bright:
 
 	tax
@@ -236,10 +403,16 @@ _pal_spr_bright:
 	sta <PAL_UPDATE
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ pal_bg_bright(unsigned char bright);
 
+.if(NL_pal_bg_bright)
+
+	.export _pal_bg_bright
+
 _pal_bg_bright:
 
 	tax
@@ -250,20 +423,32 @@ _pal_bg_bright:
 	sta <PAL_UPDATE
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ pal_bright(unsigned char bright);
 
+.if(NL_pal_bright)
+
+	.export _pal_bright
+
 _pal_bright:
 
 	jsr _pal_spr_bright
 	txa
 	jmp _pal_bg_bright
 
+.endif
+
 
 
 ;void __fastcall__ ppu_off(void);
 
+.if(NL_ppu_off)
+
+	.export _ppu_off
+
 _ppu_off:
 
 	lda <PPU_MASK_VAR
@@ -271,10 +456,16 @@ _ppu_off:
 	sta <PPU_MASK_VAR
 	jmp _ppu_wait_nmi
 
+.endif
+
 
 
 ;void __fastcall__ ppu_on_all(void);
 
+.if(NL_ppu_on_all)
+
+	.export _ppu_on_all
+
 _ppu_on_all:
 
 	lda <PPU_MASK_VAR
@@ -285,48 +476,94 @@ ppu_onoff:
 	sta <PPU_MASK_VAR
 	jmp _ppu_wait_nmi
 
+.endif
+
 
 
 ;void __fastcall__ ppu_on_bg(void);
 
+.if(NL_ppu_on_bg)
+
+	.export _ppu_on_bg
+
 _ppu_on_bg:
 
 	lda <PPU_MASK_VAR
 	ora #%00001000
 	bne ppu_onoff	;bra
 
+.endif
+
 
 
 ;void __fastcall__ ppu_on_spr(void);
 
+.if(NL_ppu_on_spr)
+
+	.export _ppu_on_spr
+
 _ppu_on_spr:
 
 	lda <PPU_MASK_VAR
 	ora #%00010000
 	bne ppu_onoff	;bra
 
+.endif
+
 
 
 ;void __fastcall__ ppu_mask(unsigned char mask);
 
+.if(NL_ppu_mask)
+
+	.export _ppu_mask
+
 _ppu_mask:
 
 	sta <PPU_MASK_VAR
 	rts
 
+.endif
+
 
 
 ;unsigned char __fastcall__ ppu_system(void);
 
+.if(NL_ppu_system)
+
+	.export _ppu_system
+
 _ppu_system:
 
 	lda <NTSC_MODE
 	rts
 
+.endif
+
+
+
+;unsigned char __fastcall__ nesclock(void);
+
+.if(NL_nesclock)
+
+	.export _nesclock
+
+_nesclock:
+
+	lda <FRAME_CNT1
+	ldx #0
+	rts
+
+.endif
+
 
 
 ;void __fastcall__ oam_clear(void);
 
+.if(NL_oam_clear)
+
+	.export _oam_clear
+
 _oam_clear:
 
 	ldx #0
@@ -340,10 +577,16 @@ _oam_clear:
 	bne @1
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ oam_size(unsigned char size);
 
+.if(NL_oam_size)
+
+	.export _oam_size
+
 _oam_size:
 
 	asl a
@@ -360,10 +603,16 @@ _oam_size:
 
 	rts
 
+.endif
+
 
 
 ;unsigned char __fastcall__ oam_spr(unsigned char x,unsigned char y,unsigned char chrnum,unsigned char attr,unsigned char sprid);
 
+.if(NL_oam_spr)
+
+	.export _oam_spr
+
 _oam_spr:
 
 	tax
@@ -395,10 +644,19 @@ _oam_spr:
 	adc #4
 	rts
 
+.endif
+
 
 
 ;unsigned char __fastcall__ oam_meta_spr(unsigned char x,unsigned char y,unsigned char sprid,const unsigned char *data);
 
+.if(NL_oam_meta_spr)
+
+	.export _oam_meta_spr
+
+	.pushseg
+	.segment "HOTCODE"		;keeps the sprite loop branches within one page
+
 _oam_meta_spr:
 
 	sta <PTR
@@ -453,10 +711,20 @@ _oam_meta_spr:
 	txa
 	rts
 
+	.assert >(*-1) = >_oam_meta_spr, error, "oam_meta_spr crosses a page, check HOTCODE"
+
+	.popseg
+
+.endif
+
 
 
 ;void __fastcall__ oam_hide_rest(unsigned char sprid);
 
+.if(NL_oam_hide_rest)
+
+	.export _oam_hide_rest
+
 _oam_hide_rest:
 
 	tax
@@ -472,10 +740,16 @@ _oam_hide_rest:
 	bne @1
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ ppu_wait_frame(void);
 
+.if(NL_ppu_wait_frame)
+
+	.export _ppu_wait_frame
+
 _ppu_wait_frame:
 
 	lda #1
@@ -499,10 +773,16 @@ _ppu_wait_frame:
 
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ ppu_wait_nmi(void);
 
+.if(NL_ppu_wait_nmi)
+
+	.export _ppu_wait_nmi
+
 _ppu_wait_nmi:
 
 	lda #1
@@ -514,10 +794,16 @@ _ppu_wait_nmi:
 	beq @1
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ vram_unrle(const unsigned char *data);
 
+.if(NL_vram_unrle)
+
+	.export _vram_unrle
+
 _vram_unrle:
 
 	tay
@@ -570,10 +856,16 @@ _vram_unrle:
 
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ scroll(unsigned int x,unsigned int y);
 
+.if(NL_scroll)
+
+	.export _scroll
+
 _scroll:
 
 	sta <TEMP
@@ -611,10 +903,16 @@ _scroll:
 	sta <PPU_CTRL_VAR
 	rts
 
+.endif
+
 
 
 ;;void __fastcall__ split(unsigned int x,unsigned int y);
 
+.if(NL_split)
+
+	.export _split
+
 _split:
 
 	jsr popax
@@ -646,10 +944,16 @@ _split:
 
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ bank_spr(unsigned char n);
 
+.if(NL_bank_spr)
+
+	.export _bank_spr
+
 _bank_spr:
 
 	and #$01
@@ -664,10 +968,16 @@ _bank_spr:
 
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ bank_bg(unsigned char n);
 
+.if(NL_bank_bg)
+
+	.export _bank_bg
+
 _bank_bg:
 
 	and #$01
@@ -683,10 +993,16 @@ _bank_bg:
 
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ vram_read(unsigned char *dst,unsigned int size);
 
+.if(NL_vram_read)
+
+	.export _vram_read
+
 _vram_read:
 
 	sta <TEMP
@@ -723,10 +1039,16 @@ _vram_read:
 
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ vram_write(unsigned char *src,unsigned int size);
 
+.if(NL_vram_write)
+
+	.export _vram_write
+
 _vram_write:
 
 	sta <TEMP
@@ -761,32 +1083,56 @@ _vram_write:
 
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ music_play(unsigned char song);
 
+.if(NL_music_play)
+
+	.export _music_play
+
 .if(FT_MUSIC_ENABLE)
 _music_play=FamiToneMusicPlay
 .else
 _music_play=FamiToneMusicStop
 .endif
 
+.endif
+
 
 
 ;void __fastcall__ music_stop(void);
 
+.if(NL_music_stop)
+
+	.export _music_stop
+
 _music_stop=FamiToneMusicStop
 
+.endif
+
 
 
 ;void __fastcall__ music_pause(unsigned char pause);
 
+.if(NL_music_pause)
+
+	.export _music_pause
+
 _music_pause=FamiToneMusicPause
 
+.endif
+
 
 
 ;void __fastcall__ sfx_play(unsigned char sound,unsigned char channel);
 
+.if(NL_sfx_play)
+
+	.export _sfx_play
+
 _sfx_play:
 
 .if(FT_SFX_ENABLE)
@@ -806,9 +1152,15 @@ _sfx_play:
 	rts
 .endif
 
+.endif
+
 
 ;void __fastcall__ sample_play(unsigned char sample);
 
+.if(NL_sample_play)
+
+	.export _sample_play
+
 .if(FT_DPCM_ENABLE)
 _sample_play=FamiToneSamplePlay
 .else
@@ -816,44 +1168,19 @@ _sample_play:
 	rts
 .endif
 
+.endif
 
-;unsigned char __fastcall__ pad_poll(unsigned char pad);
-
-_pad_poll:
-
-	tay
-	ldx #0
-
-@padPollPort:
-
-	lda #1
-	sta CTRL_PORT1
-	lda #0
-	sta CTRL_PORT1
-	lda #8
-	sta <TEMP
-
-@padPollLoop:
 
-	lda CTRL_PORT1,y
-	lsr a
-	ror <PAD_BUF,x
-	dec <TEMP
-	bne @padPollLoop
+;unsigned char __fastcall__ pad_poll(unsigned char pad);
 
-	inx
-	cpx #3
-	bne @padPollPort
+.if(NL_pad_poll)
 
-	lda <PAD_BUF
-	cmp <PAD_BUF+1
-	beq @done
-	cmp <PAD_BUF+2
-	beq @done
-	lda <PAD_BUF+1
+	.export _pad_poll
 
-@done:
+_pad_poll:
 
+	tay
+	lda <PAD_READ,y			;latched by the NMI, read once so it can't change halfway
 	sta <PAD_STATE,y
 	tax
 	eor <PAD_STATEP,y
@@ -864,10 +1191,16 @@ _pad_poll:
 
 	rts
 
+.endif
+
 
 
 ;unsigned char __fastcall__ pad_trigger(unsigned char pad);
 
+.if(NL_pad_trigger)
+
+	.export _pad_trigger
+
 _pad_trigger:
 
 	pha
@@ -877,22 +1210,48 @@ _pad_trigger:
 	lda <PAD_STATET,x
 	rts
 
+.endif
+
 
 
 ;unsigned char __fastcall__ pad_state(unsigned char pad);
 
+.if(NL_pad_state)
+
+	.export _pad_state
+
 _pad_state:
 
 	tax
 	lda <PAD_STATE,x
 	rts
 
+.endif
+
+
+
+;unsigned char __fastcall__ pad_frame(void);
+
+.if(NL_pad_frame)
+
+	.export _pad_frame
+
+_pad_frame:
+
+	lda <PAD_FRAME
+	ldx #0
+	rts
+
+.endif
+
 
 
 ;unsigned char __fastcall__ rand8(void);
 ;Galois random generator, found somewhere
 ;out: A random number 0..255
 
+.if(NL_rand8|NL_rand16)
+
 rand1:
 
 	lda <RAND_SEED
@@ -917,6 +1276,12 @@ rand2:
 	sta <RAND_SEED+1
 	rts
 
+.endif
+
+.if(NL_rand8)
+
+	.export _rand8
+
 _rand8:
 
 	jsr rand1
@@ -924,10 +1289,16 @@ _rand8:
 	adc <RAND_SEED
 	rts
 
+.endif
+
 
 
 ;unsigned int __fastcall__ rand16(void);
 
+.if(NL_rand16)
+
+	.export _rand16
+
 _rand16:
 
 	jsr rand1
@@ -936,9 +1307,15 @@ _rand16:
 
 	rts
 
+.endif
+
 
 ;void __fastcall__ set_rand(unsigned char seed);
 
+.if(NL_set_rand)
+
+	.export _set_rand
+
 _set_rand:
 
 	sta <RAND_SEED
@@ -946,29 +1323,56 @@ _set_rand:
 
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ set_vram_update(unsigned char *buf);
 
+.if(NL_set_vram_update)
+
+	.export _set_vram_update
+
 _set_vram_update:
 
-	sta <NAME_UPD_ADR+0
-	stx <NAME_UPD_ADR+1
-	ora <NAME_UPD_ADR+1
-	sta <NAME_UPD_ENABLE
+	ldy #0
+	sty <NAME_UPD_SWAP		;the NMI ignores the pointer while it is written
+	sta <NAME_UPD_NEXT+0
+	stx <NAME_UPD_NEXT+1
+	ora <NAME_UPD_NEXT+1
+	bne @commit
+	sty <NAME_UPD_ENABLE	;NULL stops the updates right away instead of on the next frame
 
 	rts
 
+@commit:
+
+	iny
+	sty <NAME_UPD_SWAP		;single store commit, the NMI swaps it in as a whole
+
+	rts
+
+.endif
+
 
 
 ;void __fastcall__ flush_vram_update(unsigned char *buf);
 
+	.pushseg
+	.segment "HOTCODE"		;the NMI update loop, kept within one page
+
+.if(NL_flush_vram_update)
+
+	.export _flush_vram_update
+
 _flush_vram_update:
 
 	sta <NAME_UPD_ADR+0
 	stx <NAME_UPD_ADR+1
 
-_flush_vram_update_nmi:
+.endif
+
+_flush_vram_update_nmi:				;always kept, called from the NMI handler
 
 	ldy #0
 
@@ -985,6 +1389,9 @@ _flush_vram_update_nmi:
 	lda (NAME_UPD_ADR),y
 	iny
 	sta PPU_DATA
+.if(CHR_RAM)
+	dec <CHR_STR_BUDGET		;every entry takes the vblank time of a streamed tile
+.endif
 	jmp @updName
 
 @updNotSeq:
@@ -995,6 +1402,8 @@ _flush_vram_update_nmi:
 	bcc @updHorzSeq
 	cpx #$ff				;is it end of the update?
 	beq @updDone
+	cpx #$c0				;is it a sequence read through a pointer?
+	bcs @updRefSeq
 
 @updVertSeq:
 
@@ -1008,6 +1417,9 @@ _flush_vram_update_nmi:
 @updNameSeq:
 
 	sta PPU_CTRL
+.if(CHR_RAM)
+	dec <CHR_STR_BUDGET
+.endif
 
 	txa
 	and #$3f
@@ -1032,14 +1444,194 @@ _flush_vram_update_nmi:
 
 	jmp @updName
 
+@updRefSeq:					;horizontal sequence, the data stays where the pointer is
+
+	and #$fb
+	sta PPU_CTRL
+.if(CHR_RAM)
+	dec <CHR_STR_BUDGET
+.endif
+
+	txa
+	and #$3f
+	sta PPU_ADDR
+	lda (NAME_UPD_ADR),y
+	iny
+	sta PPU_ADDR
+	lda (NAME_UPD_ADR),y
+	iny
+	tax
+	lda (NAME_UPD_ADR),y
+	iny
+	sta <NAME_UPD_REF+0
+	lda (NAME_UPD_ADR),y
+	iny
+	sta <NAME_UPD_REF+1
+
+	tya						;remember the list position
+	pha
+	ldy #0
+
+@updRefLoop:
+
+	lda (NAME_UPD_REF),y
+	iny
+	sta PPU_DATA
+	dex
+	bne @updRefLoop
+
+	pla
+	tay
+
+	lda <PPU_CTRL_VAR
+	sta PPU_CTRL
+
+	jmp @updName
+
 @updDone:
 
 	rts
+
+	.assert >(*-1) = >_flush_vram_update_nmi, error, "VRAM update loop crosses a page, check HOTCODE"
+
+	.popseg
 	
 	
 	
+;void __fastcall__ chr_stream(unsigned char table,const unsigned char *runs);
+
+.if(CHR_RAM)
+
+	.export _chr_stream
+
+_chr_stream:
+
+	sta <CHR_STR_SRC+0		;the NMI only streams while ppu_wait_frame/nmi waits
+	stx <CHR_STR_SRC+1
+	jsr popa
+	and #$01
+	asl a
+	asl a
+	asl a
+	asl a
+	sta <CHR_STR_TABLE
+	lda #0
+	sta <CHR_STR_LEFT
+	rts
+
+
+
+;unsigned char __fastcall__ chr_stream_busy(void);
+
+	.export _chr_stream_busy
+
+_chr_stream_busy:
+
+	lda <CHR_STR_SRC+1
+	ldx #0
+	rts
+
+
+
+;upload the runs set by chr_stream, called from the NMI after the update list: up to
+;CHR_STREAM_TILES tiles, less the palette and every update list entry of this vblank
+
+chr_stream_nmi:
+
+	ldx <CHR_STR_BUDGET
+	bpl @budget
+	ldx #0					;the update list took all of it and more
+
+@budget:
+
+	lda #CHR_STREAM_TILES	;full budget again for the next frame
+	sta <CHR_STR_BUDGET
+
+	lda <CHR_STR_SRC+1		;nothing to stream
+	beq @done
+
+@tile:
+
+	lda <CHR_STR_LEFT
+	bne @upload
+
+	ldy #0
+	lda (CHR_STR_SRC),y		;next run: address MSB, LSB and tile count, or $ff
+	cmp #$ff
+	beq @end
+	ora <CHR_STR_TABLE
+	sta <CHR_STR_ADR+1
+	iny
+	lda (CHR_STR_SRC),y
+	sta <CHR_STR_ADR+0
+	iny
+	lda (CHR_STR_SRC),y
+	sta <CHR_STR_LEFT
+	lda <CHR_STR_SRC+0
+	clc
+	adc #3
+	sta <CHR_STR_SRC+0
+	bcc @upload
+	inc <CHR_STR_SRC+1
+
+@upload:
+
+	txa						;budget used up, go on in the next frame
+	beq @done
+
+	lda <CHR_STR_ADR+1
+	sta PPU_ADDR
+	lda <CHR_STR_ADR+0
+	sta PPU_ADDR
+
+	ldy #0
+	.repeat 16
+	lda (CHR_STR_SRC),y
+	sta PPU_DATA
+	iny
+	.endrepeat
+
+	lda <CHR_STR_SRC+0
+	clc
+	adc #16
+	sta <CHR_STR_SRC+0
+	bcc @1
+	inc <CHR_STR_SRC+1
+
+@1:
+
+	lda <CHR_STR_ADR+0
+	clc
+	adc #16
+	sta <CHR_STR_ADR+0
+	bcc @2
+	inc <CHR_STR_ADR+1
+
+@2:
+
+	dec <CHR_STR_LEFT
+	dex
+	jmp @tile
+
+@end:
+
+	lda #0
+	sta <CHR_STR_SRC+1
+
+@done:
+
+	rts
+
+.endif
+
+
+
 ;void __fastcall__ vram_adr(unsigned int adr);
 
+.if(NL_vram_adr)
+
+	.export _vram_adr
+
 _vram_adr:
 
 	stx PPU_ADDR
@@ -1047,20 +1639,32 @@ _vram_adr:
 
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ vram_put(unsigned char n);
 
+.if(NL_vram_put)
+
+	.export _vram_put
+
 _vram_put:
 
 	sta PPU_DATA
 
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ vram_fill(unsigned char n,unsigned int len);
 
+.if(NL_vram_fill)
+
+	.export _vram_fill
+
 _vram_fill:
 
 	sta <LEN
@@ -1093,10 +1697,16 @@ _vram_fill:
 
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ vram_inc(unsigned char n);
 
+.if(NL_vram_inc)
+
+	.export _vram_inc
+
 _vram_inc:
 
 	ora #0
@@ -1114,10 +1724,16 @@ _vram_inc:
 
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ memcpy(void *dst,void *src,unsigned int len);
 
+.if(NL_memcpy)
+
+	.export _memcpy
+
 _memcpy:
 
 	sta <LEN
@@ -1162,10 +1778,16 @@ _memcpy:
 
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ memfill(void *dst,unsigned char value,unsigned int len);
 
+.if(NL_memfill)
+
+	.export _memfill
+
 _memfill:
 
 	sta <LEN
@@ -1208,10 +1830,16 @@ _memfill:
 
 	rts
 
+.endif
+
 
 
 ;void __fastcall__ delay(unsigned char frames);
 
+.if(NL_delay)
+
+	.export _delay
+
 _delay:
 
 	tax
@@ -1224,7 +1852,52 @@ _delay:
 
 	rts
 
+.endif
+
+
+
+;unsigned char __fastcall__ stack_watermark(void);
+
+.if(NL_stack_watermark)
+
+	.export _stack_watermark
+
+_stack_watermark:
+
+	ldx #0
+
+@1:
+
+	lda __STACK_START__,x	;count the bytes at the bottom that still hold the fill
+	cmp #STACK_FILL
+	bne @2
+	inx
+	cpx #<__STACK_SIZE__
+	bne @1
+
+@2:
+
+	stx <TEMP
+	lda #<__STACK_SIZE__
+	sec
+	sbc <TEMP
+
+	rts
+
+.endif
+
+
+
+	.include "famitone2.s"
+
+
+
+;brightness tables, read in the NMI through (PAL_BG_PTR),y and (PAL_SPR_PTR),y
+;with colors $00..$3f; they follow the FamiTone note tables in the page-aligned
+;HOTDATA segment, where none of these reads crosses a page
 
+	.pushseg
+	.segment "HOTDATA"
 
 palBrightTableL:
 
@@ -1260,4 +1933,4 @@ palBrightTable8:
 	.byte $30,$30,$30,$30,$30,$30,$30,$30,$30,$30,$30,$30,$30,$30,$30,$30
 	.byte $30,$30,$30,$30,$30,$30,$30,$30,$30,$30,$30,$30,$30,$30,$30,$30
 
-	.include "famitone2.s"
\ No newline at end of file
+	.popseg
@@ -3,7 +3,7 @@
 *  @brief      	Main game code file
 *  @author     	Lori
 *  @created 	November 26, 2017
-*  @modified   	November 27, 2017
+*  @modified   	October 19, 2026
 *      
 *  @par [explanation]
 *		> Used for global variable declarations, defines, and other
@@ -12,6 +12,11 @@
  
 #include "lib/neslib.h"
 
+// 1 for the CHR-RAM build, compile.bat sets it for cc65 and ca65 together
+#ifndef CHR_RAM
+#define CHR_RAM 0
+#endif
+
 // Put all the subsequent global vars into zeropage
 
 #pragma bss-name (push,"ZEROPAGE")
@@ -25,6 +30,9 @@ static unsigned char frameCounter;	// Tracks elapsed frames
 static unsigned char gameResult;	// Tracks game result
 static unsigned int var16Bit;		// General variable for 16-bit computations
 static unsigned char bright;		// Used in fade functions (pal_fade_to
+static unsigned char playerCount;	// 1, or 2 for the versus mode
+static unsigned char player;		// Index of the player being processed
+static unsigned char winner;		// Player who won the versus mode
 
 #pragma data-name(pop)
 #pragma bss-name (pop)
@@ -37,6 +45,43 @@ const unsigned char palette[16]={ 0x0f,0x00,0x10,0x30,0x0f,0x11,0x21,0x31,0x0f,0
 // Include sound and music handler
 #include "soundsAndMusic/soundsAndMusic.h"
 
+#if CHR_RAM
+// Background animation frames generated by tools/chrstream from the tileset
+extern const unsigned char* const bgAnimFrames[];
+
+static unsigned char bgTable;		// Pattern table on screen
+static unsigned char bgFrame;		// Animation frame on screen
+static unsigned char bgNextFrame;	// Animation frame being streamed
+#endif
+
+// Show the given background animation frame
+// CHR-ROM builds switch between the two halves of the CHR, CHR-RAM builds
+// stream the animated tiles of the frame into the pattern table that is
+// not on screen and switch to it once the upload is complete
+void bgAnimate(unsigned char frame)
+{
+#if CHR_RAM
+	if (chr_stream_busy())
+	{
+		return;
+	}
+	
+	if (bgNextFrame != bgFrame)
+	{
+		bgTable ^= 1;
+		bank_bg(bgTable);
+		bgFrame = bgNextFrame;
+	}
+	else if (frame != bgFrame)
+	{
+		bgNextFrame = frame;
+		chr_stream(bgTable ^ 1, bgAnimFrames[frame]);
+	}
+#else
+	bank_bg(frame);
+#endif
+}
+
 // Smoothly fade current bright to the given value
 // When to=0, stop music, turn display off, reset vram update and scroll
 void pal_fade_to(unsigned to)
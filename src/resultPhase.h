@@ -3,7 +3,7 @@
 *  @brief      	Title phase handler
 *  @author     	Lori
 *  @created 	November 27, 2017
-*  @modified   	November 27, 2017
+*  @modified   	October 19, 2026
 *      
 *  @par [explanation]
 *		> Holds code displaying game results
@@ -15,6 +15,14 @@
 // Constants
 #define COLOR_SWAP_FRAME_BIT 8
 
+// Versus winner message, the font tiles are the ASCII codes minus 0x20
+#define WIN_TEXT_LENGTH 13
+const unsigned char winText[MAX_PLAYERS][WIN_TEXT_LENGTH] =
+{
+	{ 0x30,0x2c,0x21,0x39,0x25,0x32,0x00,0x11,0x00,0x37,0x29,0x2e,0x33 },	// PLAYER 1 WINS
+	{ 0x30,0x2c,0x21,0x39,0x25,0x32,0x00,0x12,0x00,0x37,0x29,0x2e,0x33 }	// PLAYER 2 WINS
+};
+
 void resultPhase(void)
 {
 	// Game fail screen
@@ -52,7 +60,7 @@ void resultPhase(void)
 			++frameCounter;
 			
 			// Animate the BG via CHR bank switching
-			bank_bg((frameCounter >> 4)&1);
+			bgAnimate((frameCounter >> 4)&1);
 		
 			if (pad_trigger(0))
 			{
@@ -63,6 +71,20 @@ void resultPhase(void)
 	// Game win screen
 	else
 	{
+		// Versus: show which player won over the split line
+		if (playerCount > 1)
+		{
+			// Turn off rendering
+			ppu_off();
+			
+			vram_adr(NTADR_A((32 - WIN_TEXT_LENGTH) >> 1, 13));
+			vram_write((unsigned char*)winText[winner], WIN_TEXT_LENGTH);
+			
+			// Turn on the ppu when ready
+			ppu_wait_frame();
+			ppu_on_all();
+		}
+		
 		// Play the lose bgm
 		music_play(MUSIC_WELL_DONE);
 		
@@ -85,10 +107,11 @@ void resultPhase(void)
 			pal_col(7, (frameCounter & COLOR_SWAP_FRAME_BIT) ? 0x31 : 0x37);
 			
 			// Animate the BG via CHR bank switching
-			bank_bg((frameCounter >> 2)&1);
+			bgAnimate((frameCounter >> 2)&1);
 			
-			// Wait for any input to go back to the title screen
-			if (pad_trigger(0))
+			// Wait for any input to go back to the title screen,
+			// either player may leave the versus result
+			if (pad_trigger(0) || (playerCount > 1 && pad_trigger(1)))
 			{
 				break;
 			}
@@ -3,7 +3,7 @@
 *  @brief      	Title phase handler
 *  @author     	Lori
 *  @created 	November 26, 2017
-*  @modified   	November 27, 2017
+*  @modified   	October 19, 2026
 *      
 *  @par [explanation]
 *		> Holds code used exclusively in the title phase
@@ -35,9 +35,16 @@ void titlePhase(void)
 		pal_col(14, (frameCounter & 16) ? 0x27 : 0x25);
 		pal_col(15, (frameCounter & 16) ? 0x37 : 0x35);
 		
-		// Detect any button press to start the game
+		// Detect any button press to start the game,
+		// a press on the second controller starts the versus mode
 		if (pad_trigger(0))
 		{
+			playerCount = 1;
+			break;
+		}
+		if (pad_trigger(1))
+		{
+			playerCount = 2;
 			break;
 		}
 	}
@@ -0,0 +1,204 @@
+/******************************************************************************
+*  @file       	chrstream.cpp
+*  @brief      	Background animation data and streaming report for CHR-RAM
+*  @created 	October 19, 2026
+*  @modified   	October 19, 2026
+*
+*  @par [explanation]
+*		> Reads a CHR file made of 4 KB pattern tables, one per animation
+*		frame. The tiles that differ from the first table are the animated
+*		ones: for every frame they are written as runs of consecutive tiles
+*		to an include file that the NMI tile streamer uploads in vblank
+*		> Prints how many bytes every vblank streams, with the per-frame tile
+*		budget of crt0.s (CHR_STREAM_TILES), less CHR_STREAM_PAL on palette
+*		frames and one tile per update list entry flushed in the same vblank
+*		> Usage: chrstream [-b tiles] <tileset.chr> <chr_anim.inc>
+******************************************************************************/
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#define TILE_SIZE		16
+#define TABLE_SIZE		0x1000
+#define TABLE_TILES		(TABLE_SIZE / TILE_SIZE)
+#define CHR_BANK_SIZE	0x2000
+#define PAL_TILES		2		// CHR_STREAM_PAL in crt0.s
+#define PLAYER_ROWS		2		// update list entries per player during gameplay
+
+// Consecutive animated tiles, uploaded with one address
+struct Run
+{
+	int tile;
+	int count;
+};
+
+typedef std::vector<unsigned char> Bytes;
+
+static bool sameTile(const Bytes& chr, int frameA, int frameB, int tile)
+{
+	size_t a = frameA * TABLE_SIZE + tile * TILE_SIZE;
+	size_t b = frameB * TABLE_SIZE + tile * TILE_SIZE;
+	for (int i = 0; i < TILE_SIZE; ++i)
+	{
+		if (chr[a + i] != chr[b + i]) return false;
+	}
+	return true;
+}
+
+static bool writeInclude(const char* path, const Bytes& chr, int frames,
+	const std::vector<Run>& runs)
+{
+	FILE* out = fopen(path, "w");
+	if (!out) return false;
+
+	fprintf(out, ";background animation tiles, generated by tools/chrstream\n");
+	fprintf(out, ";do not edit, compile.bat regenerates this file from the tileset\n");
+	fprintf(out, ";run format: address MSB, address LSB (in the pattern table), tile count,\n");
+	fprintf(out, ";16 bytes per tile, the list ends with $ff\n\n");
+	fprintf(out, "\t.export _bgAnimFrames\n\n");
+
+	fprintf(out, "_bgAnimFrames:\n");
+	for (int f = 0; f < frames; ++f)
+		fprintf(out, "\t.word bgAnimFrame%d\n", f);
+
+	for (int f = 0; f < frames; ++f)
+	{
+		fprintf(out, "\nbgAnimFrame%d:\n", f);
+		for (size_t r = 0; r < runs.size(); ++r)
+		{
+			int adr = runs[r].tile * TILE_SIZE;
+			fprintf(out, "\t.byte $%02x,$%02x,%d\n", adr >> 8, adr & 0xff, runs[r].count);
+			for (int t = 0; t < runs[r].count; ++t)
+			{
+				size_t base = f * TABLE_SIZE + (runs[r].tile + t) * TILE_SIZE;
+				fprintf(out, "\t.byte ");
+				for (int i = 0; i < TILE_SIZE; ++i)
+					fprintf(out, "$%02x%s", chr[base + i], (i + 1 < TILE_SIZE) ? "," : "");
+				fprintf(out, "\t;tile $%02x\n", runs[r].tile + t);
+			}
+		}
+		fprintf(out, "\t.byte $ff\n");
+	}
+
+	fclose(out);
+	return true;
+}
+
+// Bytes uploaded by each vblank of one animation step
+static void printSchedule(int tiles, int budget)
+{
+	if (budget < 1)
+	{
+		printf("    no tiles, the stream waits for a vblank with time left\n");
+		return;
+	}
+
+	int vblank = 0;
+	while (tiles > 0)
+	{
+		int n = (tiles < budget) ? tiles : budget;
+		printf("    vblank %2d: %2d tiles, %4d bytes\n", ++vblank, n, n * TILE_SIZE);
+		tiles -= n;
+	}
+	if (!vblank) printf("    nothing to stream\n");
+}
+
+int main(int argc, char** argv)
+{
+	int budget = 4;
+	std::vector<const char*> files;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "-b" && i + 1 < argc)
+		{
+			budget = atoi(argv[++i]);
+		}
+		else
+		{
+			files.push_back(argv[i]);
+		}
+	}
+
+	if (files.size() != 2 || budget < 1)
+	{
+		fprintf(stderr, "usage: chrstream [-b tiles] <tileset.chr> <chr_anim.inc>\n");
+		return 1;
+	}
+
+	std::ifstream in(files[0], std::ios::binary);
+	if (!in)
+	{
+		fprintf(stderr, "chrstream: can't read %s\n", files[0]);
+		return 1;
+	}
+	Bytes chr((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+	if (chr.empty() || chr.size() % TABLE_SIZE)
+	{
+		fprintf(stderr, "chrstream: %s is not a whole number of 4 KB pattern tables\n",
+			files[0]);
+		return 1;
+	}
+	int frames = (int)(chr.size() / TABLE_SIZE);
+
+	// A tile is animated when any frame differs from the first one
+	std::vector<Run> runs;
+	int animated = 0;
+	for (int t = 0; t < TABLE_TILES; ++t)
+	{
+		bool changed = false;
+		for (int f = 1; f < frames && !changed; ++f)
+			changed = !sameTile(chr, 0, f, t);
+		if (!changed) continue;
+
+		++animated;
+		if (!runs.empty() && runs.back().tile + runs.back().count == t)
+		{
+			++runs.back().count;
+		}
+		else
+		{
+			Run r = { t, 1 };
+			runs.push_back(r);
+		}
+	}
+
+	if (!writeInclude(files[1], chr, frames, runs))
+	{
+		fprintf(stderr, "chrstream: can't write %s\n", files[1]);
+		return 1;
+	}
+
+	int step = animated * TILE_SIZE;
+	int romData = frames * (2 + (int)runs.size() * 3 + step + 1);
+
+	printf("Background animation streaming for %s\n\n", files[0]);
+	printf("  frames            %d\n", frames);
+	printf("  animated tiles    %d in %d runs\n", animated, (int)runs.size());
+	printf("  bytes per step    %d\n", step);
+	printf("  budget            %d tiles (%d bytes) per vblank, %d on palette frames,\n"
+		"                    less one per update list entry\n\n",
+		budget, budget * TILE_SIZE, budget - PAL_TILES);
+
+	printf("  Bytes streamed per vblank for one animation step\n\n");
+	printf("  normal frames\n");
+	printSchedule(animated, budget);
+	printf("  frames with a palette upload\n");
+	printSchedule(animated, budget - PAL_TILES);
+	printf("  gameplay, one player (%d update rows)\n", PLAYER_ROWS);
+	printSchedule(animated, budget - PLAYER_ROWS);
+	printf("  gameplay, versus (%d update rows)\n", PLAYER_ROWS * 2);
+	printSchedule(animated, budget - PLAYER_ROWS * 2);
+
+	printf("\n  Pattern data in the ROM\n\n");
+	printf("    CHR-ROM build  %6d bytes of CHR\n", (int)chr.size() < CHR_BANK_SIZE ?
+		CHR_BANK_SIZE : (int)chr.size());
+	printf("    CHR-RAM build  %6d bytes of PRG (first table %d, animation %d)\n",
+		TABLE_SIZE + romData, TABLE_SIZE, romData);
+
+	return 0;
+}
@@ -0,0 +1,300 @@
+/******************************************************************************
+*  @file       	nlsyms.cpp
+*  @brief      	Generates the list of neslib routines referenced by the game
+*  @created 	October 19, 2026
+*  @modified   	October 19, 2026
+*
+*  @par [explanation]
+*		> Reads the neslib.h prototypes and the cc65-generated assembly
+*		files, and writes an NL_REF_<name> = 0/1 line for every neslib
+*		routine. neslib.s only assembles the routines whose flag is set,
+*		so unused library code never reaches the PRG ROM
+*		> C files are read as well, for when cc65 is not at hand: their
+*		quoted includes are followed (except neslib.h itself) and the
+*		#define/#if/#ifdef/#ifndef/#else/#endif lines are honored, with
+*		the -D values given like on the cc65 command line
+*		> Usage: nlsyms [-D name=value]... <neslib.h> <module.s|main.c>...
+*		  > neslib_refs.inc
+******************************************************************************/
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+typedef std::map<std::string, std::string> Defines;
+
+// Collects the names declared as "__fastcall__ name(" in the header
+static bool readPrototypes(const char* path, std::vector<std::string>& names)
+{
+	std::ifstream in(path);
+	if (!in) return false;
+
+	const std::string key = "__fastcall__";
+	std::string line;
+	while (std::getline(in, line))
+	{
+		if (line.compare(0, 2, "//") == 0) continue;
+
+		size_t pos = line.find(key);
+		if (pos == std::string::npos) continue;
+		pos += key.size();
+
+		while (pos < line.size() && isspace((unsigned char)line[pos])) ++pos;
+		size_t end = pos;
+		while (end < line.size() &&
+			(isalnum((unsigned char)line[end]) || line[end] == '_')) ++end;
+		if (end == pos || end >= line.size() || line[end] != '(') continue;
+
+		names.push_back(line.substr(pos, end - pos));
+	}
+	return true;
+}
+
+// Collects every identifier used outside of comments and strings
+static bool readReferences(const char* path, std::set<std::string>& refs)
+{
+	std::ifstream in(path);
+	if (!in) return false;
+
+	std::string line;
+	while (std::getline(in, line))
+	{
+		bool inString = false;
+		size_t i = 0;
+		while (i < line.size())
+		{
+			char c = line[i];
+			if (inString)
+			{
+				if (c == '"') inString = false;
+				++i;
+			}
+			else if (c == '"')
+			{
+				inString = true;
+				++i;
+			}
+			else if (c == ';')
+			{
+				break;
+			}
+			else if (isalpha((unsigned char)c) || c == '_')
+			{
+				size_t start = i;
+				while (i < line.size() &&
+					(isalnum((unsigned char)line[i]) || line[i] == '_')) ++i;
+				refs.insert(line.substr(start, i - start));
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+	return true;
+}
+
+static std::string baseName(const std::string& path)
+{
+	size_t slash = path.find_last_of("/\\");
+	return (slash == std::string::npos) ? path : path.substr(slash + 1);
+}
+
+static std::string directory(const std::string& path)
+{
+	size_t slash = path.find_last_of("/\\");
+	return (slash == std::string::npos) ? "" : path.substr(0, slash + 1);
+}
+
+static std::string word(const std::string& line, size_t& i)
+{
+	while (i < line.size() && isspace((unsigned char)line[i])) ++i;
+	size_t start = i;
+	while (i < line.size() && !isspace((unsigned char)line[i])) ++i;
+	return line.substr(start, i - start);
+}
+
+// Value of a #if operand: a number, or a macro that is 0 when undefined
+static bool condition(const std::string& expr, const Defines& defines)
+{
+	std::string value = expr;
+	for (int depth = 0; depth < 8 && !value.empty() &&
+		(isalpha((unsigned char)value[0]) || value[0] == '_'); ++depth)
+	{
+		Defines::const_iterator it = defines.find(value);
+		value = (it == defines.end()) ? "0" : it->second;
+	}
+	return strtol(value.c_str(), NULL, 0) != 0;
+}
+
+// Collects the identifiers of a C file and its quoted includes as the "_name"
+// cc65 would reference them, skipping comments, strings and disabled blocks
+static bool readCReferences(const std::string& path, const std::string& header,
+	Defines& defines, std::set<std::string>& refs)
+{
+	std::ifstream in(path.c_str());
+	if (!in) return false;
+
+	std::vector<bool> active(1, true);	// nesting of #if blocks
+	std::vector<bool> taken(1, true);	// an #if branch was taken already
+	bool inComment = false;
+	std::string line;
+	while (std::getline(in, line))
+	{
+		size_t i = 0;
+		while (i < line.size() && isspace((unsigned char)line[i])) ++i;
+
+		if (!inComment && i < line.size() && line[i] == '#')
+		{
+			++i;
+			std::string directive = word(line, i);
+			std::string arg = word(line, i);
+
+			if (directive == "if" || directive == "ifdef" || directive == "ifndef")
+			{
+				bool on = (directive == "if") ? condition(arg, defines) :
+					((defines.count(arg) != 0) == (directive == "ifdef"));
+				on = on && active.back();
+				active.push_back(on);
+				taken.push_back(on);
+			}
+			else if (directive == "else" && active.size() > 1)
+			{
+				bool on = !taken.back() && active[active.size() - 2];
+				active.back() = on;
+				taken.back() = taken.back() || on;
+			}
+			else if (directive == "endif" && active.size() > 1)
+			{
+				active.pop_back();
+				taken.pop_back();
+			}
+			else if (active.back() && directive == "define")
+			{
+				std::string value = word(line, i);
+				if (value.compare(0, 2, "//") == 0 || value.compare(0, 2, "/*") == 0) value = "";
+				defines[arg] = value.empty() ? "1" : value;
+			}
+			else if (active.back() && directive == "include" && arg.size() > 2 &&
+				arg[0] == '"')
+			{
+				std::string file = arg.substr(1, arg.size() - 2);
+				if (baseName(file) == header) continue;
+				if (!readCReferences(directory(path) + file, header, defines, refs))
+				{
+					fprintf(stderr, "nlsyms: can't read %s, included by %s\n",
+						file.c_str(), path.c_str());
+					return false;
+				}
+			}
+			continue;
+		}
+		if (!active.back()) continue;
+
+		while (i < line.size())
+		{
+			char c = line[i];
+			if (inComment)
+			{
+				if (line.compare(i, 2, "*/") == 0)
+				{
+					inComment = false;
+					++i;
+				}
+				++i;
+			}
+			else if (line.compare(i, 2, "/*") == 0)
+			{
+				inComment = true;
+				i += 2;
+			}
+			else if (line.compare(i, 2, "//") == 0)
+			{
+				break;
+			}
+			else if (c == '"' || c == '\'')
+			{
+				for (++i; i < line.size() && line[i] != c; ++i)
+				{
+					if (line[i] == '\\') ++i;
+				}
+				++i;
+			}
+			else if (isalpha((unsigned char)c) || c == '_')
+			{
+				size_t start = i;
+				while (i < line.size() &&
+					(isalnum((unsigned char)line[i]) || line[i] == '_')) ++i;
+				refs.insert("_" + line.substr(start, i - start));
+			}
+			else
+			{
+				++i;
+			}
+		}
+	}
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	Defines defines;
+	std::vector<const char*> files;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "-D" && i + 1 < argc)
+		{
+			std::string def = argv[++i];
+			size_t eq = def.find('=');
+			if (eq == std::string::npos) defines[def] = "1";
+			else defines[def.substr(0, eq)] = def.substr(eq + 1);
+		}
+		else
+		{
+			files.push_back(argv[i]);
+		}
+	}
+
+	if (files.size() < 2)
+	{
+		fprintf(stderr, "usage: nlsyms [-D name=value]... <neslib.h> <module.s|main.c>...\n");
+		return 1;
+	}
+
+	std::vector<std::string> names;
+	if (!readPrototypes(files[0], names) || names.empty())
+	{
+		fprintf(stderr, "nlsyms: no prototypes found in %s\n", files[0]);
+		return 1;
+	}
+
+	std::set<std::string> refs;
+	for (size_t i = 1; i < files.size(); ++i)
+	{
+		std::string path = files[i];
+		bool isC = path.size() > 2 && path.compare(path.size() - 2, 2, ".c") == 0;
+		if (isC ? !readCReferences(path, baseName(files[0]), defines, refs) :
+			!readReferences(files[i], refs))
+		{
+			fprintf(stderr, "nlsyms: can't read %s\n", files[i]);
+			return 1;
+		}
+	}
+
+	printf(";neslib routines referenced by the game, generated by tools/nlsyms\n");
+	printf(";do not edit, compile.bat regenerates this file from the cc65 output\n\n");
+
+	for (size_t i = 0; i < names.size(); ++i)
+	{
+		int used = refs.count("_" + names[i]) ? 1 : 0;
+		printf("NL_REF_%-20s= %d\n", names[i].c_str(), used);
+	}
+
+	return 0;
+}
@@ -0,0 +1,483 @@
+/******************************************************************************
+*  @file       	pagecross.cpp
+*  @brief      	Page-crossing audit of the hot code paths in the linked ROM
+*  @created 	October 19, 2026
+*  @modified   	October 19, 2026
+*
+*  @par [explanation]
+*		> Disassembles the hot routines of the linked ROM, using the ld65
+*		labels file (-Ln) to find them, and lists every taken branch and
+*		indexed read that can cross a 256-byte page, each of which costs the
+*		6502 one extra cycle. The penalties are weighted by how often every
+*		instruction runs per frame to estimate the cycles lost per frame
+*		> Instructions inside a backward branch or jump run "iterations" times
+*		per call, the rest once. Branches are counted as always taken and
+*		indexed reads as always crossing when they can, so the estimate is
+*		a worst case
+*		> Usage: pagecross [-h label:calls:iterations]...
+*		  [-z pointer:table:maxY]... <game.nes> <labels.txt>
+*		  [<before.nes> <before_labels.txt>]
+*		  The second ROM, built before a layout change, is audited the same
+*		  way so both totals can be compared
+*		> A (zp),y read through a pointer with no -z entry is reported as
+*		an unknown pointer and counted as crossing, like any other read
+*		the audit can't bound
+******************************************************************************/
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+// iNES layout of NROM-256: 16 byte header, PRG mapped at $8000-$ffff
+#define INES_HEADER	16
+#define PRG_START	0x8000
+#define PRG_SIZE	0x8000
+
+enum Mode { IMP, ACC, IMM, ZP, ZPX, ZPY, ABS, ABX, ABY, IND, IZX, IZY, REL, BAD };
+
+struct Opcode
+{
+	const char* name;
+	Mode mode;
+};
+
+// Official 6502 opcodes, everything else stops the disassembly
+static Opcode opcodes[256];
+
+static void setOpcodes(void)
+{
+	static const struct { int code; const char* name; Mode mode; } table[] =
+	{
+		{ 0x00,"BRK",IMP },{ 0x01,"ORA",IZX },{ 0x05,"ORA",ZP  },{ 0x06,"ASL",ZP  },
+		{ 0x08,"PHP",IMP },{ 0x09,"ORA",IMM },{ 0x0a,"ASL",ACC },{ 0x0d,"ORA",ABS },
+		{ 0x0e,"ASL",ABS },{ 0x10,"BPL",REL },{ 0x11,"ORA",IZY },{ 0x15,"ORA",ZPX },
+		{ 0x16,"ASL",ZPX },{ 0x18,"CLC",IMP },{ 0x19,"ORA",ABY },{ 0x1d,"ORA",ABX },
+		{ 0x1e,"ASL",ABX },{ 0x20,"JSR",ABS },{ 0x21,"AND",IZX },{ 0x24,"BIT",ZP  },
+		{ 0x25,"AND",ZP  },{ 0x26,"ROL",ZP  },{ 0x28,"PLP",IMP },{ 0x29,"AND",IMM },
+		{ 0x2a,"ROL",ACC },{ 0x2c,"BIT",ABS },{ 0x2d,"AND",ABS },{ 0x2e,"ROL",ABS },
+		{ 0x30,"BMI",REL },{ 0x31,"AND",IZY },{ 0x35,"AND",ZPX },{ 0x36,"ROL",ZPX },
+		{ 0x38,"SEC",IMP },{ 0x39,"AND",ABY },{ 0x3d,"AND",ABX },{ 0x3e,"ROL",ABX },
+		{ 0x40,"RTI",IMP },{ 0x41,"EOR",IZX },{ 0x45,"EOR",ZP  },{ 0x46,"LSR",ZP  },
+		{ 0x48,"PHA",IMP },{ 0x49,"EOR",IMM },{ 0x4a,"LSR",ACC },{ 0x4c,"JMP",ABS },
+		{ 0x4d,"EOR",ABS },{ 0x4e,"LSR",ABS },{ 0x50,"BVC",REL },{ 0x51,"EOR",IZY },
+		{ 0x55,"EOR",ZPX },{ 0x56,"LSR",ZPX },{ 0x58,"CLI",IMP },{ 0x59,"EOR",ABY },
+		{ 0x5d,"EOR",ABX },{ 0x5e,"LSR",ABX },{ 0x60,"RTS",IMP },{ 0x61,"ADC",IZX },
+		{ 0x65,"ADC",ZP  },{ 0x66,"ROR",ZP  },{ 0x68,"PLA",IMP },{ 0x69,"ADC",IMM },
+		{ 0x6a,"ROR",ACC },{ 0x6c,"JMP",IND },{ 0x6d,"ADC",ABS },{ 0x6e,"ROR",ABS },
+		{ 0x70,"BVS",REL },{ 0x71,"ADC",IZY },{ 0x75,"ADC",ZPX },{ 0x76,"ROR",ZPX },
+		{ 0x78,"SEI",IMP },{ 0x79,"ADC",ABY },{ 0x7d,"ADC",ABX },{ 0x7e,"ROR",ABX },
+		{ 0x81,"STA",IZX },{ 0x84,"STY",ZP  },{ 0x85,"STA",ZP  },{ 0x86,"STX",ZP  },
+		{ 0x88,"DEY",IMP },{ 0x8a,"TXA",IMP },{ 0x8c,"STY",ABS },{ 0x8d,"STA",ABS },
+		{ 0x8e,"STX",ABS },{ 0x90,"BCC",REL },{ 0x91,"STA",IZY },{ 0x94,"STY",ZPX },
+		{ 0x95,"STA",ZPX },{ 0x96,"STX",ZPY },{ 0x98,"TYA",IMP },{ 0x99,"STA",ABY },
+		{ 0x9a,"TXS",IMP },{ 0x9d,"STA",ABX },{ 0xa0,"LDY",IMM },{ 0xa1,"LDA",IZX },
+		{ 0xa2,"LDX",IMM },{ 0xa4,"LDY",ZP  },{ 0xa5,"LDA",ZP  },{ 0xa6,"LDX",ZP  },
+		{ 0xa8,"TAY",IMP },{ 0xa9,"LDA",IMM },{ 0xaa,"TAX",IMP },{ 0xac,"LDY",ABS },
+		{ 0xad,"LDA",ABS },{ 0xae,"LDX",ABS },{ 0xb0,"BCS",REL },{ 0xb1,"LDA",IZY },
+		{ 0xb4,"LDY",ZPX },{ 0xb5,"LDA",ZPX },{ 0xb6,"LDX",ZPY },{ 0xb8,"CLV",IMP },
+		{ 0xb9,"LDA",ABY },{ 0xba,"TSX",IMP },{ 0xbc,"LDY",ABX },{ 0xbd,"LDA",ABX },
+		{ 0xbe,"LDX",ABY },{ 0xc0,"CPY",IMM },{ 0xc1,"CMP",IZX },{ 0xc4,"CPY",ZP  },
+		{ 0xc5,"CMP",ZP  },{ 0xc6,"DEC",ZP  },{ 0xc8,"INY",IMP },{ 0xc9,"CMP",IMM },
+		{ 0xca,"DEX",IMP },{ 0xcc,"CPY",ABS },{ 0xcd,"CMP",ABS },{ 0xce,"DEC",ABS },
+		{ 0xd0,"BNE",REL },{ 0xd1,"CMP",IZY },{ 0xd5,"CMP",ZPX },{ 0xd6,"DEC",ZPX },
+		{ 0xd8,"CLD",IMP },{ 0xd9,"CMP",ABY },{ 0xdd,"CMP",ABX },{ 0xde,"DEC",ABX },
+		{ 0xe0,"CPX",IMM },{ 0xe1,"SBC",IZX },{ 0xe4,"CPX",ZP  },{ 0xe5,"SBC",ZP  },
+		{ 0xe6,"INC",ZP  },{ 0xe8,"INX",IMP },{ 0xe9,"SBC",IMM },{ 0xea,"NOP",IMP },
+		{ 0xec,"CPX",ABS },{ 0xed,"SBC",ABS },{ 0xee,"INC",ABS },{ 0xf0,"BEQ",REL },
+		{ 0xf1,"SBC",IZY },{ 0xf5,"SBC",ZPX },{ 0xf6,"INC",ZPX },{ 0xf8,"SED",IMP },
+		{ 0xf9,"SBC",ABY },{ 0xfd,"SBC",ABX },{ 0xfe,"INC",ABX },
+		{ -1, NULL, BAD }
+	};
+
+	for (int i = 0; i < 256; ++i)
+	{
+		opcodes[i].name = "???";
+		opcodes[i].mode = BAD;
+	}
+	for (int i = 0; table[i].name; ++i)
+	{
+		opcodes[table[i].code].name = table[i].name;
+		opcodes[table[i].code].mode = table[i].mode;
+	}
+}
+
+static int operandSize(Mode mode)
+{
+	switch (mode)
+	{
+	case IMM: case ZP: case ZPX: case ZPY: case IZX: case IZY: case REL: return 1;
+	case ABS: case ABX: case ABY: case IND: return 2;
+	default: return 0;
+	}
+}
+
+// Only reads pay the extra cycle, stores and read-modify-writes always take it
+static bool isRead(const char* name)
+{
+	static const char* reads[] =
+		{ "LDA", "LDX", "LDY", "EOR", "AND", "ORA", "ADC", "SBC", "CMP", NULL };
+	for (int i = 0; reads[i]; ++i)
+		if (!strcmp(name, reads[i])) return true;
+	return false;
+}
+
+// A routine to audit and how often it runs per frame
+struct HotPath
+{
+	std::string label;
+	int calls;
+	int iterations;
+};
+
+// A zero page pointer used with (zp),y that points at the start of a table,
+// matched by its name or by a prefix of tables named prefix<digit>
+struct PointerRange
+{
+	std::string pointer;
+	std::string table;
+	int maxY;
+};
+
+struct Rom
+{
+	std::vector<unsigned char> prg;
+	std::map<std::string, unsigned> labels;
+	std::map<unsigned, std::string> names;	// First label at each address
+};
+
+static bool loadRom(const char* nesPath, const char* labelsPath, Rom& rom)
+{
+	std::ifstream nes(nesPath, std::ios::binary);
+	if (!nes) return false;
+	std::vector<unsigned char> file((std::istreambuf_iterator<char>(nes)),
+		std::istreambuf_iterator<char>());
+	if (file.size() < INES_HEADER + PRG_SIZE) return false;
+	rom.prg.assign(file.begin() + INES_HEADER, file.begin() + INES_HEADER + PRG_SIZE);
+
+	// ld65 -Ln lines look like "al 00C0A5 .nmi"
+	std::ifstream in(labelsPath);
+	if (!in) return false;
+	std::string line;
+	while (std::getline(in, line))
+	{
+		char name[256];
+		unsigned addr;
+		if (sscanf(line.c_str(), "al %x .%255s", &addr, name) != 2) continue;
+		rom.labels[name] = addr;
+		if (!rom.names.count(addr)) rom.names[addr] = name;
+	}
+	return true;
+}
+
+static int readByte(const Rom& rom, unsigned addr)
+{
+	if (addr < PRG_START || addr >= PRG_START + PRG_SIZE) return -1;
+	return rom.prg[addr - PRG_START];
+}
+
+// Size of the table starting at addr, up to the next label
+static unsigned tableSize(const Rom& rom, unsigned addr)
+{
+	std::map<unsigned, std::string>::const_iterator it = rom.names.upper_bound(addr);
+	unsigned size = (it == rom.names.end()) ? 256 : it->first - addr;
+	return (size > 256) ? 256 : size;
+}
+
+static std::string describe(const Rom& rom, unsigned addr)
+{
+	char buf[16];
+	std::map<unsigned, std::string>::const_iterator it = rom.names.find(addr);
+	if (it != rom.names.end()) return it->second;
+	sprintf(buf, "$%04X", addr);
+	return buf;
+}
+
+struct Instruction
+{
+	unsigned addr;
+	int opcode;
+	unsigned operand;
+	unsigned target;	// Branch target
+};
+
+// Disassembles a routine, stopping at the first rts/rti/jmp past every
+// forward branch
+static std::vector<Instruction> disassemble(const Rom& rom, unsigned start)
+{
+	std::vector<Instruction> code;
+	unsigned pc = start;
+	unsigned furthest = start;
+
+	while (code.size() < 4096)
+	{
+		int op = readByte(rom, pc);
+		if (op < 0 || opcodes[op].mode == BAD) break;
+
+		Instruction ins;
+		ins.addr = pc;
+		ins.opcode = op;
+		ins.operand = 0;
+		ins.target = 0;
+		int size = operandSize(opcodes[op].mode);
+		for (int i = 0; i < size; ++i)
+		{
+			int b = readByte(rom, pc + 1 + i);
+			if (b < 0) return code;
+			ins.operand |= (unsigned)b << (8 * i);
+		}
+		pc += 1 + size;
+		if (opcodes[op].mode == REL)
+		{
+			ins.target = (pc + (signed char)ins.operand) & 0xffff;
+			if (ins.target > furthest) furthest = ins.target;
+		}
+		code.push_back(ins);
+
+		const char* name = opcodes[op].name;
+		bool jump = !strcmp(name, "JMP");
+		if (jump && opcodes[op].mode == ABS && ins.operand > furthest &&
+			ins.operand < pc + 256 && ins.operand >= start)
+		{
+			// jmp used as a long forward branch inside the routine
+			furthest = ins.operand;
+		}
+		if ((jump || !strcmp(name, "RTS") || !strcmp(name, "RTI")) && pc > furthest) break;
+	}
+	return code;
+}
+
+struct Audit
+{
+	long cycles;
+	int crossings;
+	std::vector<std::string> lines;
+};
+
+static bool onePage(unsigned a, unsigned b)
+{
+	return (a & 0xff00) == (b & 0xff00);
+}
+
+static Audit audit(const Rom& rom, const HotPath& hot,
+	const std::vector<PointerRange>& pointers, bool verbose)
+{
+	Audit result;
+	result.cycles = 0;
+	result.crossings = 0;
+
+	std::map<std::string, unsigned>::const_iterator start = rom.labels.find(hot.label);
+	if (start == rom.labels.end()) return result;
+
+	std::vector<Instruction> code = disassemble(rom, start->second);
+
+	// Instructions inside a backward branch or jump form a loop
+	std::vector<int> weight(code.size(), hot.calls);
+	for (size_t i = 0; i < code.size(); ++i)
+	{
+		const Opcode& o = opcodes[code[i].opcode];
+		unsigned target = 0;
+		if (o.mode == REL) target = code[i].target;
+		else if (!strcmp(o.name, "JMP") && o.mode == ABS) target = code[i].operand;
+		if (!target || target > code[i].addr || target < start->second) continue;
+
+		for (size_t k = 0; k <= i; ++k)
+			if (code[k].addr >= target) weight[k] = hot.calls * hot.iterations;
+	}
+
+	for (size_t i = 0; i < code.size(); ++i)
+	{
+		const Instruction& ins = code[i];
+		const Opcode& o = opcodes[ins.opcode];
+		std::string why;
+
+		if (o.mode == REL && !onePage(ins.addr + 2, ins.target))
+		{
+			why = "branch to " + describe(rom, ins.target) + " crosses a page";
+		}
+		else if ((o.mode == ABX || o.mode == ABY) && isRead(o.name))
+		{
+			// Table size comes from the labels when the operand is a table start
+			unsigned span = rom.names.count(ins.operand) ? tableSize(rom, ins.operand) : 256;
+			if ((ins.operand & 0xff) + span - 1 > 0xff)
+			{
+				char buf[64];
+				sprintf(buf, " (%u bytes) can cross a page", span);
+				why = "table " + describe(rom, ins.operand) + buf;
+			}
+		}
+		else if (o.mode == IZY && isRead(o.name))
+		{
+			std::string ptr = describe(rom, ins.operand);
+			bool known = false;
+			for (size_t p = 0; p < pointers.size(); ++p)
+			{
+				if (pointers[p].pointer != ptr) continue;
+				known = true;
+
+				const std::string& table = pointers[p].table;
+				bool found = false;
+				std::map<std::string, unsigned>::const_iterator t;
+				for (t = rom.labels.begin(); t != rom.labels.end(); ++t)
+				{
+					const std::string& n = t->first;
+					if (n != table && (n.compare(0, table.size(), table) ||
+						n.size() == table.size() || !isdigit((unsigned char)n[table.size()]))) continue;
+					found = true;
+					if ((t->second & 0xff) + pointers[p].maxY > 0xff)
+						why += (why.empty() ? "(" + ptr + "),y into " : ", ") + n;
+				}
+				if (!found)
+					why += (why.empty() ? "(" + ptr + "),y into " : ", ") + table + " (not in the labels file)";
+			}
+			if (!known) why = "(" + ptr + "),y through an unknown pointer";
+			else if (!why.empty()) why += " can cross a page";
+		}
+
+		if (why.empty()) continue;
+
+		++result.crossings;
+		result.cycles += weight[i];
+		char buf[256];
+		sprintf(buf, "    $%04X %s  %4d/frame  %s", ins.addr, o.name, weight[i], why.c_str());
+		if (verbose) result.lines.push_back(buf);
+	}
+	return result;
+}
+
+static long report(const Rom& rom, const std::vector<HotPath>& hot,
+	const std::vector<PointerRange>& pointers, bool verbose)
+{
+	long total = 0;
+	for (size_t i = 0; i < hot.size(); ++i)
+	{
+		std::map<std::string, unsigned>::const_iterator it = rom.labels.find(hot[i].label);
+		if (it == rom.labels.end())
+		{
+			if (verbose) printf("  %-24s not in the labels file\n", hot[i].label.c_str());
+			continue;
+		}
+
+		Audit a = audit(rom, hot[i], pointers, verbose);
+		total += a.cycles;
+		if (!verbose) continue;
+
+		printf("  %-24s $%04X  %3d crossing(s)  %5ld cycles/frame\n",
+			hot[i].label.c_str(), it->second, a.crossings, a.cycles);
+		for (size_t k = 0; k < a.lines.size(); ++k) printf("%s\n", a.lines[k].c_str());
+	}
+	return total;
+}
+
+int main(int argc, char** argv)
+{
+	setOpcodes();
+
+	std::vector<HotPath> hot;
+	std::vector<PointerRange> pointers;
+	std::vector<const char*> files;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		if (!strcmp(argv[i], "-h") && i + 1 < argc)
+		{
+			char name[256];
+			HotPath h;
+			if (sscanf(argv[++i], "%255[^:]:%d:%d", name, &h.calls, &h.iterations) != 3)
+			{
+				fprintf(stderr, "pagecross: -h expects label:calls:iterations\n");
+				return 1;
+			}
+			h.label = name;
+			hot.push_back(h);
+		}
+		else if (!strcmp(argv[i], "-z") && i + 1 < argc)
+		{
+			char ptr[256], table[256];
+			PointerRange p;
+			if (sscanf(argv[++i], "%255[^:]:%255[^:]:%d", ptr, table, &p.maxY) != 3)
+			{
+				fprintf(stderr, "pagecross: -z expects pointer:table:maxY\n");
+				return 1;
+			}
+			p.pointer = ptr;
+			p.table = table;
+			pointers.push_back(p);
+		}
+		else
+		{
+			files.push_back(argv[i]);
+		}
+	}
+
+	if (files.size() != 2 && files.size() != 4)
+	{
+		fprintf(stderr, "usage: pagecross [-h label:calls:iterations]... "
+			"[-z pointer:table:maxY]... <game.nes> <labels.txt> "
+			"[<before.nes> <before_labels.txt>]\n");
+		return 1;
+	}
+
+	// Defaults for this game: the NMI work done every frame during a versus
+	// game, four 8-tile rows of the update list and the 2x2 metasprites of
+	// both moving block groups, up to four each
+	if (hot.empty())
+	{
+		const HotPath defaults[] =
+		{
+			{ "nmi", 1, 1 },
+			{ "_flush_vram_update_nmi", 1, 32 },
+			{ "_oam_meta_spr", 8, 4 },
+			{ "FamiToneUpdate", 1, 11 },
+			{ "_FT2ChannelUpdate", 5, 1 },
+			{ "_FT2SetInstrument", 5, 1 },
+		};
+		hot.assign(defaults, defaults + sizeof(defaults) / sizeof(defaults[0]));
+	}
+	if (pointers.empty())
+	{
+		// The NMI palette upload reads palBrightTableN with colors $00..$3f,
+		// the update loop reads the gameplay update lists (21 bytes) and the
+		// 8-tile block rows their NT_UPD_REF entries point at
+		const PointerRange defaults[] =
+		{
+			{ "PAL_BG_PTR", "palBrightTable", 0x3f },
+			{ "PAL_SPR_PTR", "palBrightTable", 0x3f },
+			{ "NAME_UPD_ADR", "_updateListA", 20 },
+			{ "NAME_UPD_ADR", "_updateListB", 20 },
+			{ "NAME_UPD_REF", "_blockRowTop", 7 },
+			{ "NAME_UPD_REF", "_blockRowBottom", 7 },
+		};
+		pointers.assign(defaults, defaults + sizeof(defaults) / sizeof(defaults[0]));
+	}
+
+	Rom after;
+	if (!loadRom(files[0], files[1], after))
+	{
+		fprintf(stderr, "pagecross: can't load %s / %s\n", files[0], files[1]);
+		return 1;
+	}
+
+	printf("Page crossings in the hot paths of %s\n\n", files[0]);
+	long total = report(after, hot, pointers, true);
+	printf("\n  worst case: %ld cycles/frame\n", total);
+
+	if (files.size() == 4)
+	{
+		Rom before;
+		if (!loadRom(files[2], files[3], before))
+		{
+			fprintf(stderr, "pagecross: can't load %s / %s\n", files[2], files[3]);
+			return 1;
+		}
+		long old = report(before, hot, pointers, false);
+		printf("  before (%s): %ld cycles/frame, %+ld\n", files[2], old, total - old);
+	}
+
+	return 0;
+}
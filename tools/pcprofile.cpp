@@ -0,0 +1,243 @@
+/******************************************************************************
+*  @file       	pcprofile.cpp
+*  @brief      	Maps the NMI PC-sampling histogram back to function names
+*  @created 	October 19, 2026
+*  @modified   	October 19, 2026
+*
+*  @par [explanation]
+*		> With PROFILER set in crt0.s, every NMI counts the PC it interrupted
+*		in one of 512 16-bit buckets, one per 64 bytes of the 32 KB PRG ROM:
+*		the LSBs at PROFILER_BUF, the MSBs 512 bytes after them. This reads
+*		that 1 KB from a RAM dump (the .sav of a flash cart for $6000, or an
+*		emulator dump of the console RAM) and the ld65 labels of the build.
+*		crt0.s writes the "PROF" signature right after the counters, a dump
+*		without it is reported as a probable wrong offset
+*		> Prints the busiest buckets with the labels they hold, then the
+*		samples per label, a bucket shared by several labels being split by
+*		the bytes each one covers. Samples in ppu_wait_frame/ppu_wait_nmi are
+*		frames that finished in time, the others show where frames overran
+*		> Usage: pcprofile [-o offset] <dump> <labels.txt>
+*		  offset of PROFILER_BUF in the dump, 0 by default
+******************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <string>
+#include <vector>
+
+#define PRG_START		0x8000
+#define PRG_SIZE		0x8000
+#define BUCKET_SIZE		64
+#define BUCKETS			(PRG_SIZE / BUCKET_SIZE)
+#define PROFILE_SIZE	(BUCKETS * 2)
+#define SIGNATURE		"PROF"
+
+struct Label
+{
+	std::string name;
+	unsigned addr;
+};
+
+struct Total
+{
+	std::string name;
+	double samples;
+};
+
+static bool byAddress(const Label& a, const Label& b)
+{
+	return a.addr < b.addr;
+}
+
+static bool bySamples(const Total& a, const Total& b)
+{
+	return a.samples > b.samples;
+}
+
+// Samples per bucket
+static std::vector<unsigned> counts(BUCKETS);
+
+static bool byCount(int a, int b)
+{
+	return counts[a] > counts[b];
+}
+
+// Code labels of the PRG ROM from "al 00C0A5 .nmi" lines, one per address
+static bool readLabels(const char* path, std::vector<Label>& labels)
+{
+	std::ifstream in(path);
+	if (!in) return false;
+
+	std::map<unsigned, std::string> names;
+	std::string line;
+	while (std::getline(in, line))
+	{
+		char name[256];
+		unsigned addr;
+		if (sscanf(line.c_str(), "al %x .%255s", &addr, name) != 2) continue;
+		if (addr < PRG_START || addr >= PRG_START + PRG_SIZE) continue;
+		// cheap local labels and the cc65 jump labels inside functions
+		if (name[0] == '@') continue;
+		if (name[0] == 'L' && strlen(name) == 5 &&
+			strspn(name + 1, "0123456789ABCDEF") == 4) continue;
+		if (!names.count(addr)) names[addr] = name;
+	}
+
+	for (std::map<unsigned, std::string>::iterator it = names.begin(); it != names.end(); ++it)
+	{
+		Label l;
+		l.name = it->second;
+		l.addr = it->first;
+		labels.push_back(l);
+	}
+	std::sort(labels.begin(), labels.end(), byAddress);
+	return true;
+}
+
+// Index of the label covering addr, -1 before the first one
+static int labelAt(const std::vector<Label>& labels, unsigned addr)
+{
+	int found = -1;
+	for (size_t i = 0; i < labels.size() && labels[i].addr <= addr; ++i) found = (int)i;
+	return found;
+}
+
+int main(int argc, char** argv)
+{
+	long offset = 0;
+	std::vector<const char*> files;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "-o" && i + 1 < argc) offset = strtol(argv[++i], NULL, 0);
+		else files.push_back(argv[i]);
+	}
+
+	if (files.size() != 2 || offset < 0)
+	{
+		fprintf(stderr, "usage: pcprofile [-o offset] <dump> <labels.txt>\n");
+		return 1;
+	}
+
+	std::ifstream dump(files[0], std::ios::binary);
+	if (!dump)
+	{
+		fprintf(stderr, "pcprofile: can't read %s\n", files[0]);
+		return 1;
+	}
+	std::vector<unsigned char> data((std::istreambuf_iterator<char>(dump)),
+		std::istreambuf_iterator<char>());
+	if (data.size() < (size_t)offset + PROFILE_SIZE)
+	{
+		fprintf(stderr, "pcprofile: %s has no %d byte profile at offset %ld\n",
+			files[0], PROFILE_SIZE, offset);
+		return 1;
+	}
+
+	size_t sign = (size_t)offset + PROFILE_SIZE;
+	if (data.size() < sign + 4 || memcmp(&data[sign], SIGNATURE, 4) != 0)
+	{
+		fprintf(stderr, "pcprofile: warning: no %s signature after the counters, "
+			"check the offset\n", SIGNATURE);
+	}
+
+	std::vector<Label> labels;
+	if (!readLabels(files[1], labels))
+	{
+		fprintf(stderr, "pcprofile: can't read %s\n", files[1]);
+		return 1;
+	}
+
+	// LSBs of all buckets first, then the MSBs
+	unsigned long total = 0;
+	for (int b = 0; b < BUCKETS; ++b)
+	{
+		counts[b] = data[offset + b] | (data[offset + BUCKETS + b] << 8);
+		total += counts[b];
+	}
+
+	printf("PC samples of %s, %lu NMIs\n", files[0], total);
+	if (!total) return 0;
+
+	// Samples per label, a bucket split by the bytes every label covers in it
+	std::vector<double> perLabel(labels.size(), 0.0);
+	double unlabeled = 0.0;
+
+	std::vector<int> busy;
+	for (int b = 0; b < BUCKETS; ++b)
+	{
+		if (!counts[b]) continue;
+		busy.push_back(b);
+
+		unsigned start = PRG_START + b * BUCKET_SIZE;
+		unsigned end = start + BUCKET_SIZE;
+		int l = labelAt(labels, start);
+		unsigned from = start;
+		while (from < end)
+		{
+			unsigned next = end;
+			if (l + 1 < (int)labels.size() && labels[l + 1].addr < end) next = labels[l + 1].addr;
+
+			double share = counts[b] * (double)(next - from) / BUCKET_SIZE;
+			if (l < 0) unlabeled += share;
+			else perLabel[l] += share;
+
+			from = next;
+			++l;
+		}
+	}
+
+	// Busiest buckets first
+	std::stable_sort(busy.begin(), busy.end(), byCount);
+
+	printf("\nBuckets of %d bytes\n\n", BUCKET_SIZE);
+	printf("  %8s %6s  %-11s  %s\n", "samples", "%", "range", "labels");
+	for (size_t i = 0; i < busy.size(); ++i)
+	{
+		int b = busy[i];
+		unsigned start = PRG_START + b * BUCKET_SIZE;
+		unsigned end = start + BUCKET_SIZE - 1;
+
+		std::string names;
+		int l = labelAt(labels, start);
+		if (l >= 0) names = labels[l].name;
+		for (size_t k = l + 1; k < labels.size() && labels[k].addr <= end; ++k)
+			names += (names.empty() ? "" : " ") + labels[k].name;
+
+		printf("  %8u %5.1f%%  $%04X-$%04X  %s\n", counts[b], 100.0 * counts[b] / total,
+			start, end, names.c_str());
+	}
+
+	std::vector<Total> totals;
+	for (size_t i = 0; i < labels.size(); ++i)
+	{
+		if (perLabel[i] <= 0.0) continue;
+		Total t;
+		t.name = labels[i].name;
+		t.samples = perLabel[i];
+		totals.push_back(t);
+	}
+	if (unlabeled > 0.0)
+	{
+		Total t;
+		t.name = "(before the first label)";
+		t.samples = unlabeled;
+		totals.push_back(t);
+	}
+	std::stable_sort(totals.begin(), totals.end(), bySamples);
+
+	printf("\nLabels\n\n");
+	printf("  %10s %6s  %s\n", "samples", "%", "label");
+	for (size_t i = 0; i < totals.size(); ++i)
+	{
+		printf("  %10.1f %5.1f%%  %s\n", totals[i].samples, 100.0 * totals[i].samples / total,
+			totals[i].name.c_str());
+	}
+
+	return 0;
+}
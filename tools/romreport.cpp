@@ -0,0 +1,230 @@
+/******************************************************************************
+*  @file       	romreport.cpp
+*  @brief      	PRG ROM size report built from the ld65 debug file
+*  @created 	October 19, 2026
+*  @modified   	October 19, 2026
+*
+*  @par [explanation]
+*		> Reads the file written by "ld65 --dbgfile" and prints the segment
+*		map of the 32 KB PRG ROM, the size of every label in it (measured
+*		up to the next label or the segment end), and the free space left
+*		> The gap ld65 leaves in front of a page-aligned segment (align =
+*		$100 in the linker config) is alignment padding, listed on its own
+*		line and not counted as free space
+*		> Usage: romreport <game.dbg>
+******************************************************************************/
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+// PRG ROM position in the iNES file: 16 byte header, then 32 KB of PRG
+#define PRG_FILE_START	0x0010
+#define PRG_FILE_SIZE	0x8000
+#define PAGE_SIZE		0x100
+
+struct Segment
+{
+	std::string name;
+	unsigned long start;	// CPU address
+	unsigned long size;
+	long fileOffset;		// -1 when the segment is not stored in the ROM
+};
+
+struct Label
+{
+	std::string name;
+	unsigned long addr;
+	int seg;
+	unsigned long size;
+};
+
+typedef std::map<std::string, std::string> Attributes;
+
+// Splits a "tag<TAB>key=value,key=value" dbg line into its attributes
+static std::string parseLine(const std::string& line, Attributes& attr)
+{
+	size_t tab = line.find('\t');
+	if (tab == std::string::npos) return "";
+
+	size_t i = tab + 1;
+	while (i < line.size())
+	{
+		size_t eq = line.find('=', i);
+		if (eq == std::string::npos) break;
+		std::string key = line.substr(i, eq - i);
+		std::string value;
+		i = eq + 1;
+		if (i < line.size() && line[i] == '"')
+		{
+			size_t close = line.find('"', i + 1);
+			if (close == std::string::npos) close = line.size();
+			value = line.substr(i + 1, close - i - 1);
+			i = close + 1;
+		}
+		else
+		{
+			size_t comma = line.find(',', i);
+			if (comma == std::string::npos) comma = line.size();
+			value = line.substr(i, comma - i);
+			i = comma;
+		}
+		if (i < line.size() && line[i] == ',') ++i;
+		attr[key] = value;
+	}
+	return line.substr(0, tab);
+}
+
+static unsigned long number(const Attributes& attr, const char* key, unsigned long def)
+{
+	Attributes::const_iterator it = attr.find(key);
+	return (it == attr.end()) ? def : strtoul(it->second.c_str(), NULL, 0);
+}
+
+static bool byAddress(const Label& a, const Label& b)
+{
+	return (a.addr != b.addr) ? (a.addr < b.addr) : (a.name < b.name);
+}
+
+static bool bySize(const Label& a, const Label& b)
+{
+	return a.size > b.size;
+}
+
+static std::map<int, Segment> segments;
+
+static bool byFileOffset(int a, int b)
+{
+	return segments[a].fileOffset < segments[b].fileOffset;
+}
+
+int main(int argc, char** argv)
+{
+	if (argc != 2)
+	{
+		fprintf(stderr, "usage: romreport <game.dbg>\n");
+		return 1;
+	}
+
+	std::ifstream in(argv[1]);
+	if (!in)
+	{
+		fprintf(stderr, "romreport: can't read %s\n", argv[1]);
+		return 1;
+	}
+
+	std::vector<Label> labels;
+	std::string line;
+	while (std::getline(in, line))
+	{
+		Attributes attr;
+		std::string tag = parseLine(line, attr);
+
+		if (tag == "seg")
+		{
+			Segment s;
+			s.name = attr["name"];
+			s.start = number(attr, "start", 0);
+			s.size = number(attr, "size", 0);
+			s.fileOffset = attr.count("ooffs") ? (long)number(attr, "ooffs", 0) : -1;
+			segments[(int)number(attr, "id", 0)] = s;
+		}
+		// Only real labels: no equates, imports or cheap local labels
+		else if (tag == "sym" && attr["type"] == "lab" && attr.count("seg") &&
+			!attr["name"].empty() && attr["name"][0] != '@')
+		{
+			Label l;
+			l.name = attr["name"];
+			l.addr = number(attr, "val", 0);
+			l.seg = (int)number(attr, "seg", 0);
+			l.size = 0;
+			labels.push_back(l);
+		}
+	}
+
+	// Segments stored in the PRG part of the ROM file, in address order
+	std::vector<int> prg;
+	for (std::map<int, Segment>::iterator it = segments.begin(); it != segments.end(); ++it)
+	{
+		const Segment& s = it->second;
+		if (s.fileOffset >= PRG_FILE_START &&
+			s.fileOffset < PRG_FILE_START + PRG_FILE_SIZE)
+		{
+			prg.push_back(it->first);
+		}
+	}
+	std::sort(prg.begin(), prg.end(), byFileOffset);
+
+	std::sort(labels.begin(), labels.end(), byAddress);
+
+	unsigned long used = 0;
+	unsigned long padding = 0;
+	printf("PRG segment map\n\n");
+	printf("  %-10s %-6s %-6s %6s\n", "segment", "start", "end", "size");
+	for (size_t i = 0; i < prg.size(); ++i)
+	{
+		const Segment& s = segments[prg[i]];
+
+		// A gap of less than a page up to a page boundary is alignment padding
+		if (i > 0)
+		{
+			const Segment& p = segments[prg[i - 1]];
+			unsigned long end = p.start + p.size;
+			unsigned long gap = (unsigned long)(s.fileOffset - p.fileOffset) - p.size;
+			if (gap && gap < PAGE_SIZE && s.start == end + gap && !(s.start % PAGE_SIZE))
+			{
+				printf("  %-10s $%04lX  $%04lX  %6lu\n", "(padding)", end, s.start - 1, gap);
+				padding += gap;
+			}
+		}
+
+		printf("  %-10s $%04lX  $%04lX  %6lu\n", s.name.c_str(), s.start,
+			s.size ? s.start + s.size - 1 : s.start, s.size);
+		used += s.size;
+	}
+	printf("\n  PRG used %lu of %d bytes, %lu of alignment padding, %lu free\n\n", used,
+		PRG_FILE_SIZE, padding, PRG_FILE_SIZE - used - padding);
+
+	printf("Labels by segment (size runs to the next label)\n");
+	std::vector<Label> all;
+	for (size_t i = 0; i < prg.size(); ++i)
+	{
+		const Segment& s = segments[prg[i]];
+		printf("\n  %s\n", s.name.c_str());
+
+		// Labels sharing an address are aliases and are printed together
+		std::vector<Label> seg;
+		for (size_t k = 0; k < labels.size(); ++k)
+		{
+			if (labels[k].seg != prg[i]) continue;
+			if (!seg.empty() && seg.back().addr == labels[k].addr)
+				seg.back().name += "=" + labels[k].name;
+			else
+				seg.push_back(labels[k]);
+		}
+
+		for (size_t k = 0; k < seg.size(); ++k)
+		{
+			unsigned long next = (k + 1 < seg.size()) ? seg[k + 1].addr : s.start + s.size;
+			seg[k].size = next - seg[k].addr;
+			printf("    $%04lX %6lu  %s\n", seg[k].addr, seg[k].size, seg[k].name.c_str());
+			all.push_back(seg[k]);
+		}
+	}
+
+	// Biggest labels first, to see where space can be reclaimed
+	std::stable_sort(all.begin(), all.end(), bySize);
+
+	printf("\nLargest labels\n\n");
+	for (size_t i = 0; i < all.size() && i < 20; ++i)
+	{
+		printf("  %6lu  %-10s %s\n", all[i].size,
+			segments[all[i].seg].name.c_str(), all[i].name.c_str());
+	}
+
+	return 0;
+}
@@ -0,0 +1,597 @@
+/******************************************************************************
+*  @file       	stackdepth.cpp
+*  @brief      	Static call graph and stack usage analyzer
+*  @created 	October 19, 2026
+*  @modified   	October 19, 2026
+*
+*  @par [explanation]
+*		> Reads the cc65-generated assembly and the library .s files, builds
+*		the call graph and reports the worst-case depth of the cc65 parameter
+*		stack (sp) and of the 6502 hardware stack for every function, with
+*		the call path that reaches it
+*		> A function is a .proc block in the cc65 output, or the code from a
+*		global label to the next one in hand-written assembly. The code is
+*		scanned linearly, which holds for cc65 output and for neslib, where
+*		every path through a loop leaves the stack level unchanged
+*		> Calls to routines found in neither the sources nor the table of
+*		nes.lib routines below are reported on stderr, and the depths that
+*		depend on them are marked as lower bounds
+*		> Usage: stackdepth [-r root]... <file.s>...
+*		  roots default to "start" (reset) and "nmi"
+******************************************************************************/
+
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// One stack-relevant instruction of a function
+struct Event
+{
+	enum Kind { SW, RUNTIME, HW, CALL, JUMP, RETURN } kind;
+	int amount;			// Bytes pushed (negative pops) for SW, RUNTIME and HW
+	std::string target;	// Called symbol for CALL and JUMP (a tail call)
+};
+
+struct Function
+{
+	std::vector<Event> events;
+	std::set<std::string> locals;	// Branch targets inside a .proc
+	std::string fallsInto;			// Next label when the code runs into it
+	bool hasCode;
+};
+
+// Result of the call graph walk for one function
+struct Depth
+{
+	int sw;				// Parameter stack (sp) bytes, including callees
+	int hw;				// Hardware stack bytes, including callees
+	std::string path;	// Call path that reaches the worst sp depth
+	bool recursive;
+	bool incomplete;	// Calls a routine that was not found
+};
+
+static std::map<std::string, Function> functions;
+static std::map<std::string, std::string> aliases;
+static std::map<std::string, Depth> depths;
+static std::map<std::string, int> nets;
+static std::set<std::string> visiting;
+static std::set<std::string> unknown;
+
+// cc65 runtime routines (nes.lib) and their effect on the parameter stack
+struct RuntimeEffect
+{
+	const char* name;
+	int effect;
+};
+
+static const RuntimeEffect runtime[] =
+{
+	{ "pusha", 1 },		{ "pusha0", 2 },	{ "pushax", 2 },	{ "pushaFF", 2 },
+	{ "push0", 2 },		{ "push1", 2 },		{ "push2", 2 },		{ "push3", 2 },
+	{ "push4", 2 },		{ "push5", 2 },		{ "push6", 2 },		{ "push7", 2 },
+	{ "pushc0", 1 },	{ "pushc1", 1 },	{ "pushc2", 1 },	{ "pushw", 2 },
+	{ "pushwysp", 2 },	{ "pushw0sp", 2 },	{ "pushb", 2 },		{ "pushbidx", 2 },
+	{ "decsp1", 1 },	{ "decsp2", 2 },	{ "decsp3", 3 },	{ "decsp4", 4 },
+	{ "decsp5", 5 },	{ "decsp6", 6 },	{ "decsp7", 7 },	{ "decsp8", 8 },
+	{ "incsp1", -1 },	{ "incsp2", -2 },	{ "incsp3", -3 },	{ "incsp4", -4 },
+	{ "incsp5", -5 },	{ "incsp6", -6 },	{ "incsp7", -7 },	{ "incsp8", -8 },
+	{ "popa", -1 },		{ "popax", -2 },	{ "staspidx", -2 },	{ "staxspidx", -2 },
+	{ NULL, 0 }
+};
+
+// nes.lib routines that leave the parameter stack alone, with the hardware
+// stack they use below their own return address. A trailing * matches every
+// routine with that prefix
+struct Library
+{
+	const char* name;
+	int hw;
+};
+
+static const Library library[] =
+{
+	{ "initlib", 2 },		// condes calls the constructors through a jsr
+	{ "zerobss", 0 },		{ "copydata", 0 },
+	{ "shrax*", 0 },		{ "shlax*", 0 },	{ "asrax*", 0 },	{ "aslax*", 0 },
+	{ "ldaxysp", 0 },		{ "ldax0sp", 0 },	{ "ldaysp", 0 },	{ "ldaxidx", 0 },
+	{ "ldaidx", 0 },		{ "ldaxi", 0 },		{ "ldai", 0 },		{ "negax", 0 },
+	{ "complax", 0 },		{ "bnega*", 0 },	{ "bool*", 0 },		{ "incax*", 0 },
+	{ "decax*", 0 },		{ "mulax*", 2 },	{ "udivax*", 2 },	{ "umul*", 2 },
+	{ NULL, 0 }
+};
+
+static bool libraryRoutine(const std::string& name, int& hw)
+{
+	for (int i = 0; library[i].name; ++i)
+	{
+		std::string entry = library[i].name;
+		bool prefix = entry[entry.size() - 1] == '*';
+		if (prefix ? name.compare(0, entry.size() - 1, entry, 0, entry.size() - 1) == 0 :
+			name == entry)
+		{
+			hw = library[i].hw;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Routines that move sp by hand instead of calling the runtime
+struct Override
+{
+	const char* name;
+	int net;
+};
+
+static const Override overrides[] =
+{
+	{ "_oam_spr", -4 },
+	{ "_oam_meta_spr", -3 },
+	{ NULL, 0 }
+};
+
+static bool runtimeEffect(const std::string& name, int& effect)
+{
+	for (int i = 0; runtime[i].name; ++i)
+	{
+		if (name == runtime[i].name)
+		{
+			effect = runtime[i].effect;
+			return true;
+		}
+	}
+	// tos* operators pop their left operand, 4 bytes for longs
+	if (name.compare(0, 3, "tos") == 0)
+	{
+		effect = (name.find("eax") != std::string::npos) ? -4 : -2;
+		return true;
+	}
+	// Everything else in the runtime works on A/X and the zero page
+	return false;
+}
+
+static std::string trim(const std::string& s)
+{
+	size_t b = 0, e = s.size();
+	while (b < e && isspace((unsigned char)s[b])) ++b;
+	while (e > b && isspace((unsigned char)s[e - 1])) --e;
+	return s.substr(b, e - b);
+}
+
+static std::string stripComment(const std::string& line)
+{
+	bool inString = false;
+	for (size_t i = 0; i < line.size(); ++i)
+	{
+		if (line[i] == '"') inString = !inString;
+		else if (line[i] == ';' && !inString) return line.substr(0, i);
+	}
+	return line;
+}
+
+static bool isIdent(const std::string& s)
+{
+	if (s.empty() || !(isalpha((unsigned char)s[0]) || s[0] == '_')) return false;
+	for (size_t i = 1; i < s.size(); ++i)
+		if (!isalnum((unsigned char)s[i]) && s[i] != '_') return false;
+	return true;
+}
+
+static std::string lower(std::string s)
+{
+	for (size_t i = 0; i < s.size(); ++i) s[i] = (char)tolower((unsigned char)s[i]);
+	return s;
+}
+
+static int immediate(const std::string& operand)
+{
+	if (operand.size() < 2 || operand[0] != '#') return -1;
+	std::string v = operand.substr(1);
+	if (v[0] == '$') return (int)strtol(v.c_str() + 1, NULL, 16);
+	if (v[0] == '%') return (int)strtol(v.c_str() + 1, NULL, 2);
+	return isdigit((unsigned char)v[0]) ? atoi(v.c_str()) : -1;
+}
+
+static void addEvent(const std::string& function, Event::Kind kind, int amount,
+	const std::string& target)
+{
+	Event e;
+	e.kind = kind;
+	e.amount = amount;
+	e.target = target;
+	functions[function].events.push_back(e);
+}
+
+// Reads one source file, adding its functions to the global table
+static bool readSource(const char* path)
+{
+	std::ifstream in(path);
+	if (!in) return false;
+
+	std::string current;	// Function the scanned code belongs to
+	bool inProc = false;
+	bool ended = true;		// Last instruction was rts/rti/jmp
+	bool hasData = false;	// Label is followed by data, not code
+	int lastY = -1;
+
+	std::string raw;
+	while (std::getline(in, raw))
+	{
+		std::string line = trim(stripComment(raw));
+		if (line.empty()) continue;
+
+		// .proc blocks in the cc65 output are a single function
+		if (line.compare(0, 5, ".proc") == 0)
+		{
+			std::string name = trim(line.substr(5));
+			current = trim(name.substr(0, name.find(':')));
+			functions[current].hasCode = true;
+			inProc = true;
+			ended = false;
+			continue;
+		}
+		if (line.compare(0, 8, ".endproc") == 0)
+		{
+			inProc = false;
+			current.clear();
+			ended = true;
+			continue;
+		}
+
+		// name = other_name aliases, like _music_stop=FamiToneMusicStop
+		size_t eq = line.find('=');
+		if (eq != std::string::npos && line[0] != '.')
+		{
+			std::string name = trim(line.substr(0, eq));
+			std::string target = trim(line.substr(eq + 1));
+			if (isIdent(name) && isIdent(target)) aliases[name] = target;
+			continue;
+		}
+
+		// Labels, possibly followed by an instruction on the same line
+		size_t colon = line.find(':');
+		if (colon != std::string::npos && isIdent(line.substr(0, colon)))
+		{
+			std::string name = line.substr(0, colon);
+			if (inProc)
+			{
+				functions[current].locals.insert(name);
+			}
+			else
+			{
+				// A label with nothing under it is another name for the next one
+				if (!current.empty() && !functions[current].hasCode && !hasData)
+				{
+					aliases[current] = name;
+					functions.erase(current);
+				}
+				else if (!current.empty() && !ended)
+				{
+					functions[current].fallsInto = name;
+				}
+				current = name;
+				functions[current];
+				ended = false;
+				hasData = false;
+			}
+			line = trim(line.substr(colon + 1));
+			if (line.empty()) continue;
+		}
+		else if (line[0] == '@')
+		{
+			// Cheap local labels are branch targets inside the function
+			if (colon == std::string::npos) continue;
+			line = trim(line.substr(colon + 1));
+			if (line.empty()) continue;
+		}
+
+		if (current.empty()) continue;
+		if (line[0] == '.')
+		{
+			// Data and segment changes end the code of a function
+			std::string directive = lower(line.substr(0, 4));
+			if (!inProc && (directive == ".res" || directive == ".byt" ||
+				directive == ".wor" || directive == ".inc" || directive == ".seg" ||
+				directive == ".add" || directive == ".dby"))
+			{
+				ended = true;
+				hasData = true;
+			}
+			continue;
+		}
+
+		std::string mnemonic = lower(line.substr(0, 3));
+		std::string operand = trim(line.substr(3));
+		functions[current].hasCode = true;
+		ended = false;
+
+		if (mnemonic == "ldy")
+		{
+			lastY = immediate(operand);
+		}
+		else if (mnemonic == "pha" || mnemonic == "php")
+		{
+			addEvent(current, Event::HW, 1, "");
+		}
+		else if (mnemonic == "pla" || mnemonic == "plp")
+		{
+			addEvent(current, Event::HW, -1, "");
+		}
+		else if (mnemonic == "rts" || mnemonic == "rti")
+		{
+			addEvent(current, Event::RETURN, 0, "");
+			ended = true;
+		}
+		else if ((mnemonic == "jsr" || mnemonic == "jmp") && isIdent(operand))
+		{
+			bool tail = (mnemonic == "jmp");
+			int effect = 0;
+			if ((operand == "addysp" || operand == "subysp") && lastY >= 0)
+			{
+				// cc65 frames wider than 8 bytes: Y holds the size
+				int size = (operand == "addysp") ? -lastY : lastY;
+				addEvent(current, tail ? Event::SW : Event::RUNTIME, size, "");
+			}
+			else if (runtimeEffect(operand, effect))
+			{
+				// A jsr to the runtime also takes 2 bytes of hardware stack
+				addEvent(current, tail ? Event::SW : Event::RUNTIME, effect, "");
+			}
+			else
+			{
+				addEvent(current, tail ? Event::JUMP : Event::CALL, 0, operand);
+			}
+			if (tail)
+			{
+				if (functions[current].events.back().kind != Event::JUMP)
+					addEvent(current, Event::RETURN, 0, "");
+				ended = true;
+			}
+		}
+		else if (mnemonic == "jmp")
+		{
+			// Indirect jumps end the function, their targets are not followed
+			ended = true;
+		}
+		else if (mnemonic[0] == 'b' && mnemonic != "bit" && mnemonic != "brk" &&
+			isIdent(operand) && !inProc)
+		{
+			// neslib branches to another routine only as a "bra", which is a
+			// tail call. Branch targets inside a .proc are resolved later
+			addEvent(current, Event::JUMP, 0, operand);
+			ended = true;
+		}
+	}
+
+	return true;
+}
+
+// Drops jumps to labels inside the same .proc, they are not calls
+static void dropLocalJumps(void)
+{
+	for (std::map<std::string, Function>::iterator it = functions.begin(); it != functions.end(); ++it)
+	{
+		Function& f = it->second;
+		std::vector<Event> kept;
+		for (size_t i = 0; i < f.events.size(); ++i)
+		{
+			const Event& e = f.events[i];
+			if ((e.kind == Event::CALL || e.kind == Event::JUMP) && f.locals.count(e.target))
+			{
+				continue;
+			}
+			kept.push_back(e);
+		}
+		f.events.swap(kept);
+	}
+}
+
+static std::string resolve(std::string name)
+{
+	for (int guard = 0; guard < 16 && aliases.count(name); ++guard) name = aliases[name];
+	return name;
+}
+
+// Parameter stack bytes a function leaves behind on return, negative when
+// it pops its own arguments
+static int netEffect(const std::string& name)
+{
+	for (int i = 0; overrides[i].name; ++i)
+		if (name == overrides[i].name) return overrides[i].net;
+
+	std::map<std::string, int>::iterator cached = nets.find(name);
+	if (cached != nets.end()) return cached->second;
+
+	std::map<std::string, Function>::iterator it = functions.find(name);
+	if (it == functions.end()) return 0;
+
+	nets[name] = 0;		// Breaks recursion
+	int level = 0;
+	int net = 0;
+	bool done = false;
+	const std::vector<Event>& events = it->second.events;
+	for (size_t i = 0; i < events.size() && !done; ++i)
+	{
+		switch (events[i].kind)
+		{
+		case Event::SW:
+		case Event::RUNTIME:	level += events[i].amount; break;
+		case Event::CALL:	level += netEffect(resolve(events[i].target)); break;
+		case Event::JUMP:	net = level + netEffect(resolve(events[i].target)); done = true; break;
+		case Event::RETURN:	net = level; done = true; break;
+		default:			break;
+		}
+	}
+	if (!done)
+	{
+		net = level;
+		if (!it->second.fallsInto.empty()) net += netEffect(it->second.fallsInto);
+	}
+
+	nets[name] = net;
+	return net;
+}
+
+// Worst-case stack depth of a function including everything it calls
+static Depth analyze(const std::string& name)
+{
+	std::map<std::string, Depth>::iterator cached = depths.find(name);
+	if (cached != depths.end()) return cached->second;
+
+	Depth d;
+	d.sw = 0;
+	d.hw = 0;
+	d.path = name;
+	d.recursive = false;
+	d.incomplete = false;
+
+	std::map<std::string, Function>::iterator it = functions.find(name);
+	if (it == functions.end())
+	{
+		if (libraryRoutine(name, d.hw)) return d;
+		if (!unknown.count(name))
+			fprintf(stderr, "stackdepth: warning: %s not found, its stack use is not counted\n",
+				name.c_str());
+		unknown.insert(name);
+		d.incomplete = true;
+		return d;
+	}
+	if (visiting.count(name))
+	{
+		d.recursive = true;
+		return d;
+	}
+	visiting.insert(name);
+
+	std::vector<Event> events = it->second.events;
+	if (!it->second.fallsInto.empty())
+	{
+		Event e;
+		e.kind = Event::JUMP;
+		e.amount = 0;
+		e.target = it->second.fallsInto;
+		events.push_back(e);
+	}
+
+	// Linear scan: code after a return or a jump is reached by a branch
+	// from above, at the same stack level
+	std::string worstCallee;
+	int level = 0, hwLevel = 0;
+	for (size_t i = 0; i < events.size(); ++i)
+	{
+		const Event& e = events[i];
+		if (e.kind == Event::SW || e.kind == Event::RUNTIME)
+		{
+			level += e.amount;
+			if (level > d.sw)
+			{
+				d.sw = level;
+				worstCallee.clear();
+			}
+			if (e.kind == Event::RUNTIME && hwLevel + 2 > d.hw) d.hw = hwLevel + 2;
+		}
+		else if (e.kind == Event::HW)
+		{
+			hwLevel += e.amount;
+			if (hwLevel > d.hw) d.hw = hwLevel;
+		}
+		else if (e.kind == Event::CALL || e.kind == Event::JUMP)
+		{
+			std::string target = resolve(e.target);
+			Depth callee = analyze(target);
+			int sw = level + callee.sw;
+			int hw = hwLevel + (e.kind == Event::CALL ? 2 : 0) + callee.hw;
+			if (callee.recursive) d.recursive = true;
+			if (callee.incomplete) d.incomplete = true;
+			if (sw > d.sw || (sw == d.sw && callee.sw > 0 && worstCallee.empty()))
+			{
+				d.sw = sw;
+				worstCallee = callee.path;
+			}
+			if (hw > d.hw) d.hw = hw;
+			if (e.kind == Event::CALL) level += netEffect(target);
+		}
+	}
+	if (!worstCallee.empty()) d.path = name + " > " + worstCallee;
+
+	visiting.erase(name);
+	depths[name] = d;
+	return d;
+}
+
+int main(int argc, char** argv)
+{
+	std::vector<std::string> roots;
+	int files = 0;
+
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "-r" && i + 1 < argc)
+		{
+			roots.push_back(argv[++i]);
+		}
+		else if (!readSource(argv[i]))
+		{
+			fprintf(stderr, "stackdepth: can't read %s\n", argv[i]);
+			return 1;
+		}
+		else
+		{
+			++files;
+		}
+	}
+	if (!files)
+	{
+		fprintf(stderr, "usage: stackdepth [-r root]... <file.s>...\n");
+		return 1;
+	}
+	dropLocalJumps();
+
+	if (roots.empty())
+	{
+		roots.push_back("start");
+		roots.push_back("nmi");
+	}
+
+	// The NMI can fire anywhere, so its hardware stack use adds to the worst
+	// main-thread depth (plus the 3 bytes of the interrupt itself)
+	int hwTotal = 0;
+	printf("Worst case per root\n\n");
+	for (size_t i = 0; i < roots.size(); ++i)
+	{
+		Depth d = analyze(resolve(roots[i]));
+		printf("  %-12s sp %4d bytes  hw %4d bytes%s%s\n", roots[i].c_str(), d.sw, d.hw,
+			d.recursive ? "  (recursive, unbounded)" : "",
+			d.incomplete ? "  (lower bound, see below)" : "");
+		printf("    %s\n", d.path.c_str());
+		hwTotal += d.hw + (roots[i] == "nmi" ? 3 : 0);
+	}
+	printf("\n  hardware stack with all roots nested: %d bytes\n", hwTotal);
+
+	printf("\nPer function (sp/hw include callees, net is sp change on return,\n"
+		"* marks lower bounds)\n\n");
+	printf("  %-28s %5s %5s  %5s  %s\n", "function", "sp", "hw", "net", "worst path");
+	for (std::map<std::string, Function>::iterator it = functions.begin(); it != functions.end(); ++it)
+	{
+		if (!it->second.hasCode) continue;
+		Depth d = analyze(it->first);
+		printf("  %-28s %5d %5d%s %5d  %s\n", it->first.c_str(), d.sw, d.hw,
+			d.incomplete ? "*" : " ", netEffect(it->first), d.path.c_str());
+	}
+
+	if (!unknown.empty())
+	{
+		printf("\nNot found in the sources, their own stack use is missing from the totals:\n ");
+		for (std::set<std::string>::iterator it = unknown.begin(); it != unknown.end(); ++it)
+			printf(" %s", it->c_str());
+		printf("\n");
+	}
+
+	return 0;
+}
@@ -0,0 +1,427 @@
+/******************************************************************************
+*  @file       	timingwindows.cpp
+*  @brief      	Per-level timing windows of the block placement
+*  @created 	October 19, 2026
+*  @modified   	October 19, 2026
+*
+*  @par [explanation]
+*		> Replays the gamePhase.h movement rules: blockPosX in 12:4 fixed
+*		point moved by the level speed every frame, the bounce at the play
+*		area edges and the rounding to 16 pixel coordinates. For every level,
+*		block group width, start direction and play area, the reachable
+*		(position, direction) states are enumerated from the spawn until one
+*		repeats, with a hash of the states already seen
+*		> The targets of a level are the coordinates the groups of every
+*		lower level can land on: minStackCoordX only moves when a group lands
+*		right of it, so the stack edge can date from any level below. For
+*		each one it prints the frames after the spawn
+*		where a press is perfect (all blocks land), partial (some are lost)
+*		or losing, up to the end of the first period of the movement.
+*		Targets that no press can hit perfectly are reported as impossible
+*		> The movement repeats, so a window that runs to the end of the
+*		period goes on with the frames after the period start: it is printed
+*		with the frame numbers of the next period (28-34 for 28 and 1-6 of a
+*		28 frame period) and its length is the whole joined window
+*		> Usage: timingwindows [-j threads] [-s] <gameConstants.h> <gamePhase.h>
+*		  -s prints the summary lines only
+******************************************************************************/
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Fixed-point and tile constants of gamePhase.h
+#define FP_BITS			4
+#define TILE_SIZE_BIT	4
+
+// Press outcomes
+enum Outcome { PERFECT, PARTIAL, LOSING, OUTCOMES };
+static const char* outcomeNames[OUTCOMES] = { "perfect", "partial", "losing" };
+
+// Game constants read from the sources
+struct Rules
+{
+	int initSpeed;
+	int incrementSpeed;
+	int winStackHeight;
+	int initBlockSize;
+	int blockSide;
+	int screenWidth;
+};
+
+// Play area of one player, as the areaMinX/areaMaxX/areaCenterX tables
+struct Area
+{
+	const char* name;
+	int minX;
+	int maxX;
+	int centerX;
+};
+
+// One (level, width, direction, area) case, filled in by a worker thread
+struct Task
+{
+	int area;
+	int level;
+	int size;			// Blocks in the group
+	bool startRight;
+
+	// Results
+	int period;			// Frames before the movement repeats
+	int periodStart;	// First frame of the repeating part
+	std::vector<int> coords;	// Coordinate after the move of frame 1..n
+	std::vector<bool> reached;	// Coordinates the group can be placed at
+};
+
+// Reads "#define NAME value" lines with a plain number as value
+static bool readDefines(const char* path, std::map<std::string, int>& defines)
+{
+	std::ifstream in(path);
+	if (!in) return false;
+
+	std::string line;
+	while (std::getline(in, line))
+	{
+		std::istringstream words(line);
+		std::string directive, name, value;
+		if (!(words >> directive >> name >> value) || directive != "#define") continue;
+
+		char* end;
+		long number = strtol(value.c_str(), &end, 0);
+		if (end != value.c_str() && *end == '\0') defines[name] = (int)number;
+	}
+	return true;
+}
+
+static bool getDefine(const std::map<std::string, int>& defines, const char* name, int& value)
+{
+	std::map<std::string, int>::const_iterator it = defines.find(name);
+	if (it == defines.end())
+	{
+		fprintf(stderr, "timingwindows: %s not found\n", name);
+		return false;
+	}
+	value = it->second;
+	return true;
+}
+
+// blockCoordX for a position: the pixel column rounded to 16 pixels
+static int coordOf(unsigned pos)
+{
+	return ((((pos & 0xffff) >> FP_BITS) + 8) >> TILE_SIZE_BIT) & 0xff;
+}
+
+// Moves the group frame by frame from the spawn until a state repeats
+static void explore(const Rules& rules, const Area& area, Task& task)
+{
+	const unsigned speed = (rules.initSpeed + task.level * rules.incrementSpeed) & 0xff;
+	const int width = (rules.blockSide * task.size) & 0xff;
+
+	unsigned pos = (unsigned)area.centerX << FP_BITS;
+	bool right = task.startRight;
+
+	// State (position, direction) -> frame it was first seen at
+	std::unordered_map<unsigned, int> seen;
+	int frame = 0;
+	while (true)
+	{
+		unsigned key = (pos << 1) | (right ? 1 : 0);
+		std::unordered_map<unsigned, int>::iterator it = seen.find(key);
+		if (it != seen.end())
+		{
+			task.periodStart = it->second + 1;
+			task.period = frame - it->second;
+			break;
+		}
+		seen[key] = frame;
+
+		// One frame of gamePhase: move, round, then bounce at the edges
+		pos = (right ? pos + speed : pos - speed) & 0xffff;
+		task.coords.push_back(coordOf(pos));
+		if ((int)(pos >> FP_BITS) <= area.minX ||
+			(int)(pos >> FP_BITS) >= area.maxX - width)
+		{
+			right = !right;
+		}
+		++frame;
+	}
+
+	task.reached.assign(256, false);
+	for (size_t i = 0; i < task.coords.size(); ++i) task.reached[task.coords[i]] = true;
+}
+
+// The press outcome for a group at coord landing on a stack at target
+static Outcome outcomeOf(int coord, int target, int size)
+{
+	int off = (coord < target) ? target - coord : coord - target;
+	if (off == 0) return PERFECT;
+	return (off < size) ? PARTIAL : LOSING;
+}
+
+// Consecutive frames with the same outcome, as indexes into the outcomes
+struct Run
+{
+	int start;
+	int end;
+};
+
+// Frame ranges of one outcome, as "a-b,c,d-e". The outcomes from index
+// repeat on repeat again after the last one, so the run that ends the list
+// is joined with the one going on from there
+static std::string windows(const std::vector<Outcome>& outcomes, int first, int repeat,
+	Outcome which, int& frames, int& shortest)
+{
+	const int count = (int)outcomes.size();
+	std::vector<Run> runs;
+	int i = 0;
+	while (i < count)
+	{
+		if (outcomes[i] != which)
+		{
+			++i;
+			continue;
+		}
+		Run r = { i, i };
+		while (r.end + 1 < count && outcomes[r.end + 1] == which) ++r.end;
+		runs.push_back(r);
+		i = r.end + 1;
+	}
+
+	// Frames the last run goes on for in the next period, and the run it
+	// goes into when that run starts right at the repeat
+	int wrapped = 0;
+	int joined = -1;
+	if (!runs.empty() && runs.back().end == count - 1)
+	{
+		for (size_t k = 0; k < runs.size(); ++k)
+		{
+			if (runs[k].start > repeat || runs[k].end < repeat) continue;
+			// A run holding the whole period never ends, it is left as it is
+			if (k + 1 == runs.size()) break;
+			wrapped = runs[k].end - repeat + 1;
+			if (runs[k].start == repeat) joined = (int)k;
+		}
+	}
+
+	std::string text;
+	frames = 0;
+	shortest = 0;
+	for (size_t k = 0; k < runs.size(); ++k)
+	{
+		int start = runs[k].start;
+		int end = runs[k].end;
+		frames += end - start + 1;
+		if (k + 1 == runs.size()) end += wrapped;
+
+		// The part at the start of the period is the same window as the
+		// joined one, cut short on the first pass
+		int length = end - start + 1;
+		if ((int)k != joined && (!shortest || length < shortest)) shortest = length;
+
+		char range[32];
+		if (end == start) snprintf(range, sizeof(range), "%d", first + start);
+		else snprintf(range, sizeof(range), "%d-%d", first + start, first + end);
+		if (!text.empty()) text += ",";
+		text += range;
+	}
+	return text.empty() ? "-" : text;
+}
+
+int main(int argc, char** argv)
+{
+	unsigned threads = std::thread::hardware_concurrency();
+	bool summaryOnly = false;
+	std::vector<const char*> files;
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "-j" && i + 1 < argc) threads = (unsigned)atoi(argv[++i]);
+		else if (arg == "-s") summaryOnly = true;
+		else files.push_back(argv[i]);
+	}
+	if (threads < 1) threads = 1;
+
+	if (files.size() != 2)
+	{
+		fprintf(stderr, "usage: timingwindows [-j threads] [-s] "
+			"<gameConstants.h> <gamePhase.h>\n");
+		return 1;
+	}
+
+	std::map<std::string, int> defines;
+	for (size_t i = 0; i < files.size(); ++i)
+	{
+		if (!readDefines(files[i], defines))
+		{
+			fprintf(stderr, "timingwindows: can't read %s\n", files[i]);
+			return 1;
+		}
+	}
+
+	Rules rules;
+	if (!getDefine(defines, "INIT_SPEED", rules.initSpeed) ||
+		!getDefine(defines, "INCREMENT_SPEED", rules.incrementSpeed) ||
+		!getDefine(defines, "WIN_STACK_HEIGHT", rules.winStackHeight) ||
+		!getDefine(defines, "INIT_BLOCK_SIZE", rules.initBlockSize) ||
+		!getDefine(defines, "BLOCK_SIDE", rules.blockSide) ||
+		!getDefine(defines, "SCREEN_WIDTH", rules.screenWidth))
+	{
+		return 1;
+	}
+
+	// The play areas of gamePhase.h: one player, then the two versus halves
+	const int screenMin = rules.blockSide;
+	const int screenMax = rules.screenWidth - rules.blockSide;
+	const int screenHalf = rules.screenWidth / 2;
+	const int align = ~(rules.blockSide - 1);	// Versus spawns are rounded down to a block
+	const Area areas[] =
+	{
+		{ "single", screenMin, screenMax, 128 - rules.blockSide },
+		{ "versus 1", screenMin, screenHalf, ((screenMin + screenHalf) / 2 - rules.blockSide) & align },
+		{ "versus 2", screenHalf, screenMax, ((screenHalf + screenMax) / 2 - rules.blockSide) & align },
+	};
+	const int areaCount = (int)(sizeof(areas) / sizeof(areas[0]));
+
+	std::vector<Task> tasks;
+	for (int a = 0; a < areaCount; ++a)
+	{
+		for (int level = 0; level < rules.winStackHeight; ++level)
+		{
+			for (int size = rules.initBlockSize; size > 0; --size)
+			{
+				for (int dir = 1; dir >= 0; --dir)
+				{
+					// The first group always starts to the right
+					if (level == 0 && (dir == 0 || size != rules.initBlockSize)) continue;
+
+					Task t;
+					t.area = a;
+					t.level = level;
+					t.size = size;
+					t.startRight = (dir != 0);
+					t.period = 0;
+					t.periodStart = 0;
+					tasks.push_back(t);
+				}
+			}
+		}
+	}
+
+	// Every worker takes the next case until none are left
+	std::atomic<size_t> next(0);
+	std::vector<std::thread> workers;
+	for (unsigned i = 0; i < threads; ++i)
+	{
+		workers.push_back(std::thread([&]()
+		{
+			size_t k;
+			while ((k = next++) < tasks.size())
+				explore(rules, areas[tasks[k].area], tasks[k]);
+		}));
+	}
+	for (size_t i = 0; i < workers.size(); ++i) workers[i].join();
+
+	printf("Placement timing windows, frames counted from the spawn of the group\n");
+	printf("speed %d + %d per level, %d levels, blocks of %d pixels\n",
+		rules.initSpeed, rules.incrementSpeed, rules.winStackHeight, rules.blockSide);
+
+	int impossible = 0;
+	int lastArea = -1;
+	int lastLevel = -1;
+	for (size_t k = 0; k < tasks.size(); ++k)
+	{
+		const Task& t = tasks[k];
+		const Area& area = areas[t.area];
+		const int speed = (rules.initSpeed + t.level * rules.incrementSpeed) & 0xff;
+
+		if (t.area != lastArea)
+		{
+			printf("\n== %s play area, x %d..%d, spawn at %d\n", area.name,
+				area.minX, area.maxX, area.centerX);
+			lastArea = t.area;
+			lastLevel = -1;
+		}
+		if (t.level != lastLevel)
+		{
+			printf("\n  level %d: speed %d (%d.%02d px/frame)\n", t.level + 1, speed,
+				speed >> FP_BITS, (speed & 15) * 100 / 16);
+			lastLevel = t.level;
+		}
+
+		int lo = 255, hi = 0;
+		for (size_t i = 0; i < t.coords.size(); ++i)
+		{
+			if (t.coords[i] < lo) lo = t.coords[i];
+			if (t.coords[i] > hi) hi = t.coords[i];
+		}
+
+		printf("    %d blocks, %s: repeats every %d frames from frame %d, coordinates %d..%d\n",
+			t.size, t.startRight ? "right" : "left", t.period, t.periodStart, lo, hi);
+
+		// The first group sets the stack, so any press is perfect
+		if (t.level == 0)
+		{
+			printf("      any press is perfect\n");
+			continue;
+		}
+
+		// Every coordinate the stack below can have: where the groups of any
+		// lower level, as wide or wider than this one, can land
+		std::vector<bool> targets(256, false);
+		for (size_t b = 0; b < tasks.size(); ++b)
+		{
+			const Task& below = tasks[b];
+			if (below.area != t.area || below.level >= t.level || below.size < t.size)
+				continue;
+			for (int c = 0; c < 256; ++c)
+				if (below.reached[c]) targets[c] = true;
+		}
+
+		int worst = 0;
+		int missing = 0;
+		for (int target = 0; target < 256; ++target)
+		{
+			if (!targets[target]) continue;
+
+			std::vector<Outcome> outcomes(t.coords.size());
+			for (size_t i = 0; i < t.coords.size(); ++i)
+				outcomes[i] = outcomeOf(t.coords[i], target, t.size);
+
+			int frames[OUTCOMES], shortest[OUTCOMES];
+			std::string text[OUTCOMES];
+			for (int o = 0; o < OUTCOMES; ++o)
+				text[o] = windows(outcomes, 1, t.periodStart - 1, (Outcome)o, frames[o],
+					shortest[o]);
+
+			if (!frames[PERFECT])
+			{
+				++missing;
+				++impossible;
+			}
+			else if (!worst || shortest[PERFECT] < worst)
+			{
+				worst = shortest[PERFECT];
+			}
+
+			if (summaryOnly) continue;
+			printf("      target %2d%s\n", target, frames[PERFECT] ? "" : "  IMPOSSIBLE");
+			for (int o = 0; o < OUTCOMES; ++o)
+			{
+				printf("        %-8s %3d frames  %s\n", outcomeNames[o], frames[o],
+					text[o].c_str());
+			}
+		}
+		printf("      shortest perfect window %d frames, %d impossible targets\n",
+			worst, missing);
+	}
+
+	printf("\n%d impossible targets in total\n", impossible);
+	return 0;
+}